@@ -0,0 +1,90 @@
+//
+// Micro-benchmarks for the Snobol III interpreter.
+// Each case runs a small program in-process and reports the execution time
+// of the generic statement path against the fused one (superinstructions).
+//
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "sno.h"
+
+struct BenchCase {
+    const char *name;
+    const char *program;
+    std::string input;
+};
+
+//
+// Compile and run a program, returning the execution time in milliseconds.
+//
+static double run(const BenchCase &bench, bool superinstructions)
+{
+    std::ostringstream output;
+    SnobolContext ctx(output);
+    std::istringstream source(bench.program);
+    std::istringstream input(bench.input);
+
+    ctx.superinstructions = superinstructions;
+    ctx.compile_program(source);
+
+    auto start = std::chrono::steady_clock::now();
+    ctx.execute_program(input);
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+//
+// Best of several runs, to filter out noise.
+//
+static double best(const BenchCase &bench, bool superinstructions)
+{
+    double t = run(bench, superinstructions);
+    for (int i = 1; i < 5; i++)
+        t = std::min(t, run(bench, superinstructions));
+    return t;
+}
+
+static std::string lines(int count, const std::string &line)
+{
+    std::string text;
+    for (int i = 0; i < count; i++)
+        text += line + "\n";
+    return text;
+}
+
+int main()
+{
+    const BenchCase cases[] = {
+        { "read/write",
+          "loop    x = syspit              /f(end)\n"
+          "        syspot = x              /(loop)\n"
+          "end     syspot = \"done\"\n",
+          lines(200000, "the quick brown fox") },
+        { "increment",
+          "start   n = \"0\"\n"
+          "loop    n = n + \"1\"\n"
+          "        n \"200000\"              /f(loop)\n"
+          "end     syspot = n\n",
+          "" },
+        { "find",
+          "loop    x = syspit              /f(end)\n"
+          "        x \"fox\"                 /f(loop)\n"
+          "        n = n + \"1\"             /(loop)\n"
+          "end     syspot = n\n",
+          lines(200000, "the quick brown fox jumps over the lazy dog") },
+    };
+
+    std::cout << std::left << std::setw(14) << "case" << std::right << std::setw(12)
+              << "generic ms" << std::setw(12) << "fused ms" << std::setw(10) << "speedup"
+              << "\n";
+    for (const auto &bench : cases) {
+        double generic = best(bench, false);
+        double fused   = best(bench, true);
+        std::cout << std::left << std::setw(14) << bench.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(12) << generic << std::setw(12) << fused
+                  << std::setprecision(2) << std::setw(9) << generic / fused << "x\n";
+    }
+    return 0;
+}
@@ -1,32 +1,130 @@
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 
 #include "sno.h"
 
+static void usage()
+{
+    std::cout << "Usage: sno [OPTIONS] FILE\n"
+              << "       sno [OPTIONS] --compile FILE -o IMAGE\n"
+              << "       sno [OPTIONS] --translate FILE -o OUTPUT.cpp\n"
+              << "Options: --bignum, --depth N, --steps N, --time SECONDS\n";
+}
+
 //
 // Main entry point for the Snobol III interpreter.
 // Opens input file if provided, initializes built-in symbols, compiles program,
 // and executes it starting from the "start" label if defined.
+// With --compile, the compiled program is saved as an image instead,
+// which can later be given in place of the source file.
+// With --translate, it is written out as a C++ program.
+// With --bignum, arithmetic overflowing 64 bits is done with arbitrary precision.
+// With --depth, at most N function calls may be active at once.
+// With --steps, a pattern match that backtracks more than N times fails,
+// and so does a statement whose matches take more than N steps together.
+// With --time, the program stops after the given number of seconds.
 //
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        std::cout << "Usage: sno FILE\n";
-        return 1;
-    }
+    const char *source = nullptr;
+    const char *image  = nullptr;
+    bool translate     = false;
+    bool bignum        = false;
+    long depth         = 0;
+    long steps         = 0;
+    long seconds       = 0;
+    char *end;
 
-    // Open input file
-    std::ifstream file_input(argv[1]);
-    if (!file_input.is_open()) {
-        std::cerr << "cannot open input" << std::endl;
+    for (;;) {
+        if (argc > 1 && std::strcmp(argv[1], "--bignum") == 0) {
+            bignum = true;
+            argc--;
+            argv++;
+        } else if (argc > 2 && std::strcmp(argv[1], "--depth") == 0) {
+            depth = std::strtol(argv[2], &end, 10);
+            if (*end != '\0' || depth <= 0) {
+                usage();
+                return 1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (argc > 2 && std::strcmp(argv[1], "--steps") == 0) {
+            steps = std::strtol(argv[2], &end, 10);
+            if (*end != '\0' || steps <= 0) {
+                usage();
+                return 1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else if (argc > 2 && std::strcmp(argv[1], "--time") == 0) {
+            seconds = std::strtol(argv[2], &end, 10);
+            if (*end != '\0' || seconds <= 0) {
+                usage();
+                return 1;
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+    if (argc == 2) {
+        source = argv[1];
+    } else if (argc == 5 && std::strcmp(argv[3], "-o") == 0 &&
+               (std::strcmp(argv[1], "--compile") == 0 ||
+                std::strcmp(argv[1], "--translate") == 0)) {
+        source    = argv[2];
+        image     = argv[4];
+        translate = (std::strcmp(argv[1], "--translate") == 0);
+    } else {
+        usage();
         return 1;
     }
 
     // Create context with stream references
     SnobolContext ctx(std::cout);
+    ctx.bignums = bignum;
+    if (depth > 0)
+        ctx.max_depth = depth;
+    ctx.max_steps  = steps;
+    ctx.time_limit = seconds;
+
+    if (image == nullptr && SnobolContext::is_image(source)) {
+        // Load precompiled program
+        if (!ctx.load_image(source)) {
+            std::cerr << "bad image" << std::endl;
+            return 1;
+        }
+    } else {
+        // Open input file
+        std::ifstream file_input(source);
+        if (!file_input.is_open()) {
+            std::cerr << "cannot open input" << std::endl;
+            return 1;
+        }
+
+        // Compile program from file
+        ctx.compile_program(file_input);
+    }
+
+    if (image != nullptr) {
+        std::ofstream file_output(image, std::ios::binary);
+        if (translate)
+            ctx.translate(file_output);
+        else
+            ctx.save_image(file_output);
+        if (!file_output.good()) {
+            std::cerr << "cannot write output" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-    // Compile program from file and execute with input from stdin
-    ctx.compile_program(file_input);
+    // Execute with input from stdin
     ctx.execute_program(std::cin);
+    if (ctx.match_aborts != 0)
+        std::cerr << ctx.match_aborts << " pattern matches exceeded --steps" << std::endl;
 
     return 0;
 }
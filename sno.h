@@ -2,8 +2,14 @@
 #define SNO_H
 
 #include <array>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 //
@@ -48,6 +54,13 @@ enum class Token {
     TOKEN_STRING      = 15, // String literal
     TOKEN_LPAREN      = 16, // Left parenthesis
 
+    // Specialised operators, see infer()
+    TOKEN_INT_PLUS  = 17, // Addition of integer operands
+    TOKEN_INT_MINUS = 18, // Subtraction of integer operands
+    TOKEN_INT_MULT  = 19, // Multiplication of integer operands
+    TOKEN_INT_DIV   = 20, // Division of integer operands
+    TOKEN_INT_CAT   = 21, // Concatenation with an integer operand
+
     // Runtime/evaluation operations
     EXPR_VAR_REF  = 0,  // Variable reference TODO: use unique value
     EXPR_VALUE    = 51, // Value
@@ -55,12 +68,23 @@ enum class Token {
     EXPR_SYSPIT   = 53, // System input function
     EXPR_SYSPOT   = 54, // System output
     EXPR_FUNCTION = 55, // Function
+    EXPR_INTEGER  = 56, // Integer value, converted to a string on demand, see text()
 
     // Statement types
     STMT_SIMPLE  = 100, // Expression evaluation statement
     STMT_MATCH   = 101, // Pattern matching statement
     STMT_ASSIGN  = 102, // Assignment statement
     STMT_REPLACE = 103, // Pattern replacement
+
+    // Fused statement types (superinstructions), see fuse()
+    STMT_READ  = 104, // Read a line into a variable: x = syspit
+    STMT_WRITE = 105, // Write a variable or literal: syspot = x
+    STMT_INCR  = 106, // Add a literal to a variable: n = n + "1"
+    STMT_FIND  = 107, // Search a variable for a literal: x "lit"
+    STMT_TAIL  = 108, // Return the result of a call: f = g(x) /(return)
+
+    // Replacement of every match, see replace_all()
+    STMT_GLOBAL = 109, // x pattern == value
 };
 
 //
@@ -73,11 +97,151 @@ struct Node {
     char ch;
 
     int equal(const Node *other) const;
-    int bextend(const Node *last);
-    int ubextend(const Node *last);
     void debug_print(std::ostream &os, int depth = 0, int max_depth = 10) const;
 };
 
+//
+// Entry of the expression evaluation stack
+//
+struct Operand {
+    Node *head; // Value string, or symbol of a variable
+    Token typ;  // EXPR_VALUE or EXPR_VAR_REF
+};
+
+//
+// Call whose arguments are being evaluated, see eval()
+//
+struct PendingCall {
+    Node *call;  // Call node of the expression
+    Node *param; // Next parameter to bind
+    Node *arg;   // Next argument to evaluate
+    size_t mark; // Bindings of the call start here, see unbind()
+    size_t top;  // Operand slot of the function
+};
+
+//
+// Value of a symbol saved while a function call rebinds it, see unbind()
+//
+struct Binding {
+    Node *sym;   // Parameter, or function whose return value is saved
+    Node *value; // Saved value
+    Token typ;   // Saved type of sym
+};
+
+//
+// Activation of a function, see run()
+//
+struct Frame {
+    const Node *body; // First statement of the function
+    const Node *stmt; // Statement that made the call, continued on return
+    int step;         // Where that statement continues, see perform()
+    bool success;     // Outcome of that statement, for a call in its goto
+    Node *value;      // Target or subject evaluated before the call
+    Node *match;      // Match found before the call
+    Node *list;       // Call node of the suspended expression
+    size_t base;      // Operand stack base of the suspended expression
+    size_t calls;     // Pending calls base of the suspended expression
+    int mode;         // Mode of the suspended expression, see eval()
+    int tail;         // Tail call mode of the suspended expression
+    size_t top;       // Operand slot of the function
+    Node *fn;         // Name node of the running function, see reuse()
+    size_t mark;      // Bindings of the call start here
+    Node *result;     // Value to return if a tail call fails
+    bool recover;     // Whether result is set
+    bool memo;        // The result is cached when the frame returns, see remember()
+};
+
+//
+// Cached results of a function declared with memo, see recall()
+//
+struct MemoResult {
+    std::string value;
+    bool failed;
+};
+
+struct MemoTable {
+    std::list<std::pair<std::string, MemoResult>> entries; // Most recently used first
+    std::unordered_map<std::string, decltype(entries)::iterator> index;
+};
+
+//
+// Call of a memo function whose result is not cached yet
+//
+struct MemoCall {
+    const Node *fn;  // Function name node
+    std::string key; // Argument values, see recall()
+};
+
+//
+// Kinds of pattern components, see search()
+//
+enum class PatternKind {
+    SIMPLE,      // Value to match: "a", x, $x
+    VARIABLE,    // String variable: *x*, *(x)*, **
+    ALTERNATION, // Alternatives: *a/b*, *(a/b)*
+};
+
+typedef std::array<int, 256> SkipTable;
+
+//
+// Pattern component. Constant parts are filled in when the pattern
+// is compiled, the others on each search.
+//
+struct PatternComponent {
+    PatternKind kind;
+    bool balanced;         // *(...)*: the substring must be balanced
+    bool dynamic;          // Values are evaluated on each search
+    const Node *expr[2];   // Expressions of the values, if dynamic
+    Node *target;          // Variable assigned the substring, or null
+    Node *alt[2];          // Value of a simple component, or the two alternatives
+    bool seek;             // String variable followed by a string: skip to it
+    int size;              // Length of the value of a simple component
+    const SkipTable *skip; // Skip table of a simple component, or null
+};
+
+//
+// Pattern compiled on its first search, see compile_pattern()
+//
+struct CompiledPattern {
+    std::vector<PatternComponent> components;
+    std::vector<SkipTable> skips; // Of constant components
+    bool dynamic;                 // Some component is evaluated on each search
+    bool backtracks;              // Several choice points, see search()
+    bool balanced;                // Has a balanced string variable, see bextend()
+    int minimum;                  // Shortest subject it can match, if not dynamic
+};
+
+//
+// Choice point of search(): the substring a string variable or alternation
+// matched. Positions are given by the character before them, so null is
+// the start of the subject.
+//
+struct MatchChoice {
+    size_t component; // Index of the component
+    Node *start;      // Position the substring starts at
+    Node *end;        // Position it ends at
+    int length;       // Length of the substring, for string variables
+    int alternative;  // Alternative matched, for alternations
+};
+
+//
+// Component index and position from which a match cannot succeed
+//
+typedef std::pair<size_t, const Node *> MatchState;
+
+struct MatchStateHash {
+    size_t operator()(const MatchState &s) const
+    {
+        return std::hash<const Node *>()(s.second) * 31 + s.first;
+    }
+};
+
+//
+// Matching right parenthesis of each left parenthesis of a subject,
+// and the length of the parenthesized string, see bextend()
+//
+typedef std::unordered_map<const Node *, std::pair<Node *, int>> ParenIndex;
+
 //
 // Snobol interpreter context class
 // Holds all global state previously stored in global variables
@@ -107,6 +271,7 @@ public:
     Node *lookdef{};
     Node *lookret{};
     Node *lookfret{};
+    Node *lookmemo{};
 
     // Execution state
     Node *program{};
@@ -114,13 +279,67 @@ public:
     int rfail{};
     int lc{};
     Node *schar{};
-    Node *current_line{}; // Current input line being processed
-    int line_flag{};      // Flag for end of line
-    int compon_next{};    // Flag for compon() to reuse current character
+    Node *current_line{};           // Current input line being processed
+    int line_flag{};                // Flag for end of line
+    int compon_next{};              // Flag for compon() to reuse current character
+    std::vector<Operand> operands;  // Evaluation stack shared by all eval() calls
+    std::vector<PendingCall> calls; // Calls whose arguments are being evaluated
+    std::vector<Frame> frames;      // Active function calls
+    std::vector<Binding> bindings;  // Values saved by active calls
+    bool suspend_calls{};           // Let the next eval() leave its statement at a call
+    bool suspended{};               // eval() left its statement at a call, see run()
+    bool resuming{};                // The next eval() continues the expression of frames.back()
+    int tail_call{};                // The next eval() is a tail call, see reuse()
+    bool reused{};                  // eval() reused the running function's frame
+    size_t nesting{};               // Calls running on the C++ stack, see nest()
+    uintptr_t stack_base{};         // Stack address of the outermost of them
+
+    // Cached results of memo functions
+    std::unordered_map<const Node *, MemoTable> memos; // By function name node
+    std::vector<MemoCall> memo_calls;                  // Of frames with memo set
+
+    // Compiled patterns, by pattern node
+    std::unordered_map<const Node *, CompiledPattern> patterns;
+
+    // Match state of search(), kept between calls so it does not allocate
+    std::vector<PatternComponent> match_components; // Evaluated dynamic patterns
+    std::vector<SkipTable> match_skips;             // Of their evaluated strings
+    std::vector<MatchChoice> match_choices;         // Of the running match
+    std::unordered_set<MatchState, MatchStateHash> match_failed; // Of the running match
+    ParenIndex match_parens;                                     // Of the running match
+    std::vector<std::pair<Node *, int>> match_open;              // Building match_parens
+
+    // Compiler options
+    bool superinstructions{ true }; // Fuse common statement shapes, see fuse()
+    bool inference{ true };         // Specialise integer-only variables, see infer()
+
+    // Symbol ch of variables inferred to hold only integers
+    static constexpr char INTEGER_VARIABLE = 'i';
+
+    // Name node ch of functions whose results are cached, see memoize()
+    static constexpr char MEMO_FUNCTION = 'm';
+
+    // Runtime options
+    bool bignums{};             // Arbitrary-precision arithmetic when integers overflow, see bigop()
+    size_t max_depth{ 100000 }; // Most active function calls, see run()
+    size_t memo_size{ 4096 };   // Most results cached per memo function, see remember()
+    uint64_t max_steps{};       // Most backtracking steps per pattern match, or 0, see spend()
+    long time_limit{};          // Seconds a run may take, or 0, see start_clock()
+
+    // Guardrails of the runtime options
+    std::chrono::steady_clock::time_point deadline; // End of the time limit
+    uint64_t ticks{};                               // Statements performed, see perform()
+    size_t match_aborts{};                          // Matches that ran out of steps
+    uint64_t statement_steps{};                     // Of the running statement, see spend()
+    int matching{};                                 // Active search() and replace_all()
+
+    // Runs function bodies in place of the statement loop, set by translated programs
+    void (*run_body)(SnobolContext &ctx, const Node &body){};
 
     // Methods from sno1.c
     void compile_program(std::istream &input);
     void execute_program(std::istream &input);
+    void start_clock();
     void mes(const char *s);
     Node &init(const char *s, Token t);
     Node *syspit();
@@ -130,8 +349,10 @@ public:
     void free_node(Node &pointer);
     Node &look(const Node &string);
     Node *copy(const Node *string);
-    int strbin(const Node *string);
-    Node &binstr(int binary);
+    int64_t strbin(const Node *string);
+    Node &binstr(int64_t binary);
+    Node &integer(int64_t binary);
+    Node *text(const Node *value);
     Node &add(const Node &string1, const Node &string2);
     Node &sub(const Node &string1, const Node &string2);
     Node &mult(const Node &string1, const Node &string2);
@@ -151,21 +372,57 @@ public:
     Node &push(Node *stack); // Can be null, must stay as pointer
     Node *pop(Node *stack);  // Can be null, must stay as pointer
     Node &expr(Node *start, Token eof, Node &e);
+    void fold(Node &list);
     Node &match(Node *start, Node &m);
+    bool is_tail_call(const Node *value, const Node &g) const;
+    Token fuse(const Node &stmt) const;
     Node *compile();
 
     // Methods from sno3.c
+    CompiledPattern &compile_pattern(const Node &arg);
+    bool spend(uint64_t &steps);
     Node *search(const Node &arg, Node *r);
+    bool replace_all(const Node &arg, const Node &value, Node *r, Node *&result);
 
     // Methods from sno4.c
-    Node *eval_operand(Node &ptr);
+    Node *eval_operand(const Operand &ptr);
+    bool int_operand(const Operand &ptr, int64_t &n);
+    Node *text_operand(const Operand &ptr);
     Node *eval(Node &e, int t);
     Node *doop(Token op, const Node &arg1, const Node &arg2);
+    Node *unbind(Node &fn, size_t mark);
+    void reuse(const PendingCall &c, bool recover);
     Node *execute(const Node &e);
+    void run(const Node *c);
+    bool perform(const Node &e);
+    void check_deadline();
+    void nest();
+    Node *jump(const Node &e, bool success);
     void assign(Node &adr, Node &val); // val is deleted, so non-const
 
+    // Methods from sno5.cpp
+    void save_image(std::ostream &out) const;
+    bool load_image(const char *path);
+    bool load_image(const void *data, size_t size);
+    static bool is_image(const char *path);
+
+    // Methods from sno6.cpp
+    void translate(std::ostream &out) const;
+
+    // Methods from sno7.cpp
+    Node *bigop(Token op, const Node &arg1, const Node &arg2);
+
+    // Methods from sno8.cpp
+    void infer();
+
+    // Methods from sno9.cpp
+    void memoize();
+    int recall(const Node &fn, Node *&value);
+    void remember(const Node *value, bool failed);
+
     // Standalone functions (no context parameter)
     static CharClass char_class(int c);
+    static bool arith(Token op, int64_t a, int64_t b, int64_t &result);
 
 private:
     // Private helper methods
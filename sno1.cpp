@@ -20,8 +20,10 @@ SnobolContext::SnobolContext(std::ostream &output) : fin(&std::cin), fout(output
     lookdef   = &init("define", Token::EXPR_VAR_REF);
     lookret   = &init("return", Token::EXPR_VAR_REF);
     lookfret  = &init("freturn", Token::EXPR_VAR_REF);
+    lookmemo  = &init("memo", Token::EXPR_VAR_REF);
     init("syspit", Token::EXPR_SYSPIT);
     init("syspot", Token::EXPR_SYSPOT);
+    operands.reserve(64);
 }
 
 void SnobolContext::compile_program(std::istream &input)
@@ -37,7 +39,10 @@ void SnobolContext::compile_program(std::istream &input)
         cur->head = next;
     }
     cur->head = nullptr; // Terminate statement list
-    cfail     = 1;       // Enable compilation failure mode
+    if (inference)
+        infer();
+    memoize();
+    cfail = 1; // Enable compilation failure mode
     fin       = &std::cin;
 }
 
@@ -55,12 +60,21 @@ void SnobolContext::execute_program(std::istream &input)
     }
 
     fin = &input;
-    while ((c = execute(*c)) != nullptr)
-        ;
+    start_clock();
+    run(c);
     flush();
     fin = &std::cin;
 }
 
+//
+// Start the time limit of a run, if there is one.
+//
+void SnobolContext::start_clock()
+{
+    if (time_limit > 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(time_limit);
+}
+
 //
 // Print a message string to output.
 //
@@ -217,6 +231,7 @@ Node &SnobolContext::alloc()
     // Reuse node from free list
     f        = freelist;
     freelist = freelist->head;
+    f->typ   = Token::TOKEN_END; // Not an integer value, see integer()
     return *f;
 }
 
@@ -258,6 +273,7 @@ Node &SnobolContext::look(const Node &string)
     j->head = copy(&string);
     j->tail = nullptr;
     j->typ  = Token::EXPR_VAR_REF;
+    j->ch   = 0;
     return *j;
 }
 
@@ -272,6 +288,8 @@ Node *SnobolContext::copy(const Node *string)
 
     if (string == nullptr)
         return (nullptr);
+    if (string->typ == Token::EXPR_INTEGER)
+        return (&integer(strbin(string)));
     i = l = &alloc();
     j_src = string;
     k     = string->tail;
@@ -402,6 +420,28 @@ void Node::debug_print(std::ostream &os, int depth, int max_depth) const
         os << "STRING";
     } else if (typ == Token::TOKEN_LPAREN) {
         os << "LPAREN";
+    } else if (typ == Token::TOKEN_INT_PLUS) {
+        os << "INT_PLUS";
+    } else if (typ == Token::TOKEN_INT_MINUS) {
+        os << "INT_MINUS";
+    } else if (typ == Token::TOKEN_INT_MULT) {
+        os << "INT_MULT";
+    } else if (typ == Token::TOKEN_INT_DIV) {
+        os << "INT_DIV";
+    } else if (typ == Token::TOKEN_INT_CAT) {
+        os << "INT_CAT";
+    } else if (typ == Token::STMT_READ) {
+        os << "STMT_READ";
+    } else if (typ == Token::STMT_WRITE) {
+        os << "STMT_WRITE";
+    } else if (typ == Token::STMT_INCR) {
+        os << "STMT_INCR";
+    } else if (typ == Token::STMT_FIND) {
+        os << "STMT_FIND";
+    } else if (typ == Token::STMT_TAIL) {
+        os << "STMT_TAIL";
+    } else if (typ == Token::STMT_GLOBAL) {
+        os << "STMT_GLOBAL";
     } else {
         os << "UNKNOWN(" << typ_val << ")";
     }
@@ -445,21 +485,25 @@ void Node::debug_print(std::ostream &os, int depth, int max_depth) const
 //
 // Convert a string node representing a number to an integer.
 // Handles negative numbers and validates digit characters.
+// A number that does not fit in 64 bits fails the statement.
 //
-int SnobolContext::strbin(const Node *string)
+int64_t SnobolContext::strbin(const Node *string)
 {
-    int n, m, sign;
+    uint64_t n, limit;
+    int m;
     const Node *p, *q, *s;
 
     s = string;
     n = 0;
     if (s == nullptr)
         return (0);
-    p    = s->head;
-    q    = s->tail;
-    sign = 1;
+    if (s->typ == Token::EXPR_INTEGER)
+        return (reinterpret_cast<intptr_t>(s->tail));
+    p     = s->head;
+    q     = s->tail;
+    limit = INT64_MAX;
     if (char_class(p->ch) == CharClass::MINUS) { // minus
-        sign = -1;
+        limit = static_cast<uint64_t>(INT64_MAX) + 1;
         if (p == q)
             return (0);
         p = p->head;
@@ -468,48 +512,135 @@ loop:
     m = p->ch - '0';
     if (m > 9 || m < 0)
         writes("bad integer string");
+    if (n > (limit - m) / 10) {
+        rfail = 1; // Overflow
+        return (0);
+    }
     n = n * 10 + m;
     if (p == q)
-        return (n * sign);
+        return (limit == INT64_MAX ? static_cast<int64_t>(n) : static_cast<int64_t>(0 - n));
     p = p->head;
     goto loop;
 }
 
 //
 // Convert an integer to a string node.
-// Builds the string representation digit by digit, handling negative numbers.
+// Digits are produced two at a time from a table, least significant first,
+// into a buffer which is then copied into nodes.
 //
-Node &SnobolContext::binstr(int binary)
+Node &SnobolContext::binstr(int64_t binary)
 {
-    int n, sign;
+    static const char pairs[] = "00010203040506070809"
+                                "10111213141516171819"
+                                "20212223242526272829"
+                                "30313233343536373839"
+                                "40414243444546474849"
+                                "50515253545556575859"
+                                "60616263646566676869"
+                                "70717273747576777879"
+                                "80818283848586878889"
+                                "90919293949596979899";
+    char buf[20]; // Sign and 19 digits
+    char *b, *end;
+    uint64_t n;
+    unsigned i;
     Node *m, *q;
     Node &p = alloc();
 
-    n    = binary;
-    q    = &alloc();
-    sign = 1;
-    if (binary < 0) {
-        sign = -1;
-        n    = -binary;
+    n   = binary < 0 ? 0 - static_cast<uint64_t>(binary) : binary;
+    end = b = buf + sizeof(buf);
+    while (n >= 100) {
+        i    = static_cast<unsigned>(n % 100) * 2;
+        n    = n / 100;
+        *--b = pairs[i + 1];
+        *--b = pairs[i];
+    }
+    if (n >= 10) {
+        i    = static_cast<unsigned>(n) * 2;
+        *--b = pairs[i + 1];
+        *--b = pairs[i];
+    } else {
+        *--b = static_cast<char>('0' + n);
+    }
+    if (binary < 0)
+        *--b = '-';
+
+    q = &p;
+    while (b != end) {
+        m       = &alloc();
+        m->ch   = *b++;
+        q->head = m;
+        q       = m;
     }
     p.tail = q;
-loop:
-    q->ch = n % 10 + '0';
-    n     = n / 10;
-    if (n == 0) {
-        if (sign < 0) {
-            m       = &alloc();
-            m->head = q;
-            q       = m;
-            q->ch   = '-';
-        }
-        p.head = q;
-        return p;
+    return p;
+}
+
+//
+// Apply an arithmetic operator to two integers.
+// Returns false, with a result of 0, on overflow or division by zero.
+//
+bool SnobolContext::arith(Token op, int64_t a, int64_t b, int64_t &result)
+{
+    bool overflow;
+
+    result = 0;
+    switch (op) {
+    case Token::TOKEN_PLUS:
+        overflow = __builtin_add_overflow(a, b, &result);
+        break;
+    case Token::TOKEN_MINUS:
+        overflow = __builtin_sub_overflow(a, b, &result);
+        break;
+    case Token::TOKEN_MULT:
+        overflow = __builtin_mul_overflow(a, b, &result);
+        break;
+    case Token::TOKEN_DIV:
+        overflow = (b == 0 || (a == INT64_MIN && b == -1));
+        if (!overflow)
+            result = a / b;
+        break;
+    default:
+        return false;
     }
-    m       = &alloc();
-    m->head = q;
-    q       = m;
-    goto loop;
+    if (overflow)
+        result = 0;
+    return !overflow;
+}
+
+//
+// Make an integer value. The number is kept in the tail of the header
+// node and only turned into digits when text() is called, so results of
+// arithmetic can be used again by arithmetic without formatting them.
+//
+Node &SnobolContext::integer(int64_t binary)
+{
+    Node &p = alloc();
+
+    p.head = nullptr;
+    p.tail = reinterpret_cast<Node *>(static_cast<intptr_t>(binary));
+    static_assert(sizeof(intptr_t) >= sizeof(int64_t), "integer values need 64-bit pointers");
+    p.typ  = Token::EXPR_INTEGER;
+    return p;
+}
+
+//
+// Make sure a value is a string, converting an integer value in place.
+// The header node is kept, so the value may be shared by its holder.
+//
+Node *SnobolContext::text(const Node *value)
+{
+    Node *v = const_cast<Node *>(value);
+    Node *s;
+
+    if (v == nullptr || v->typ != Token::EXPR_INTEGER)
+        return (v);
+    s       = &binstr(strbin(v));
+    v->head = s->head;
+    v->tail = s->tail;
+    v->typ  = Token::TOKEN_END;
+    free_node(*s);
+    return (v);
 }
 
 //
@@ -517,7 +648,7 @@ loop:
 //
 Node &SnobolContext::add(const Node &string1, const Node &string2)
 {
-    return binstr(strbin(&string1) + strbin(&string2));
+    return *text(doop(Token::TOKEN_PLUS, string1, string2));
 }
 
 //
@@ -525,7 +656,7 @@ Node &SnobolContext::add(const Node &string1, const Node &string2)
 //
 Node &SnobolContext::sub(const Node &string1, const Node &string2)
 {
-    return binstr(strbin(&string1) - strbin(&string2));
+    return *text(doop(Token::TOKEN_MINUS, string1, string2));
 }
 
 //
@@ -533,7 +664,7 @@ Node &SnobolContext::sub(const Node &string1, const Node &string2)
 //
 Node &SnobolContext::mult(const Node &string1, const Node &string2)
 {
-    return binstr(strbin(&string1) * strbin(&string2));
+    return *text(doop(Token::TOKEN_MULT, string1, string2));
 }
 
 //
@@ -541,7 +672,7 @@ Node &SnobolContext::mult(const Node &string1, const Node &string2)
 //
 Node &SnobolContext::divide(const Node &string1, const Node &string2)
 {
-    return binstr(strbin(&string1) / strbin(&string2));
+    return *text(doop(Token::TOKEN_DIV, string1, string2));
 }
 
 //
@@ -552,6 +683,8 @@ Node *SnobolContext::cat(const Node *string1, const Node *string2)
 {
     Node *a, *b;
 
+    string1 = text(string1);
+    string2 = text(string2);
     if (string1 == nullptr)
         return (copy(string2));
     if (string2 == nullptr)
@@ -588,6 +721,10 @@ void SnobolContext::delete_string(Node *string)
 
     if (string == nullptr)
         return;
+    if (string->typ == Token::EXPR_INTEGER) {
+        free_node(*string);
+        return;
+    }
     a = string;
     b = string->tail;
     while (a != b) {
@@ -603,7 +740,7 @@ void SnobolContext::delete_string(Node *string)
 //
 void SnobolContext::sysput(Node *string)
 {
-    syspot(string);
+    syspot(text(string));
     delete_string(string);
 }
 
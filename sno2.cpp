@@ -57,7 +57,7 @@ Node &SnobolContext::compon()
     case CharClass::ASTERISK: // Asterisk - could be multiplication or unanchored search
         a     = schar;
         schar = getc_char();
-        if (char_class(schar->ch) == CharClass::WHITESPACE)
+        if (schar == nullptr || char_class(schar->ch) == CharClass::WHITESPACE)
             a->typ = Token::TOKEN_MULT; // Multiplication (followed by space)
         else
             a->typ = Token::TOKEN_UNANCHORED; // Unanchored search
@@ -67,7 +67,7 @@ Node &SnobolContext::compon()
     case CharClass::SLASH: // Division - could be pattern alternation
         a     = schar;
         schar = getc_char();
-        if (char_class(schar->ch) == CharClass::WHITESPACE)
+        if (schar == nullptr || char_class(schar->ch) == CharClass::WHITESPACE)
             a->typ = Token::TOKEN_DIV; // Division (followed by space)
         else
             a->typ = Token::TOKEN_ALTERNATION; // Pattern alternation
@@ -323,6 +323,7 @@ l6:
     stack = pop(stack);
     if (stack == nullptr) {
         list->typ = Token::TOKEN_END;
+        fold(*e.tail);
         return *comp;
     }
     if (op1 == Token::TOKEN_MARKER) {  // Left parenthesis marker
@@ -339,6 +340,82 @@ l6:
     goto l6;
 }
 
+//
+// Check whether a literal string is a valid operand for arithmetic,
+// so that folding it can never raise "bad integer string".
+//
+static bool is_integer(const Node *string)
+{
+    const Node *p;
+
+    if (string == nullptr)
+        return false;
+    p = string->head;
+    if (SnobolContext::char_class(p->ch) == CharClass::MINUS) {
+        if (p == string->tail)
+            return false;
+        p = p->head;
+    }
+    for (;;) {
+        if (p->ch < '0' || p->ch > '9')
+            return false;
+        if (p == string->tail)
+            return true;
+        p = p->head;
+    }
+}
+
+//
+// Fold constant subexpressions of a compiled expression list.
+// A binary operator applied to two string literals is computed once here
+// and replaced by a single literal holding the result.
+// Arithmetic is folded only when both operands are integers
+// and the result is well defined; anything else is left for run time.
+//
+void SnobolContext::fold(Node &list)
+{
+    Node *p, *q, *o;
+    Token op;
+
+again:
+    for (p = &list; p->typ != Token::TOKEN_END; p = p->head) {
+        q = p->head;
+        if (p->typ != Token::TOKEN_STRING || q->typ != Token::TOKEN_STRING)
+            continue;
+        o  = q->head;
+        op = o->typ;
+        switch (op) {
+        case Token::TOKEN_WHITESPACE: // Concatenation
+            break;
+        case Token::TOKEN_DIV:   // Division
+        case Token::TOKEN_PLUS:  // Addition
+        case Token::TOKEN_MINUS: // Subtraction
+        case Token::TOKEN_MULT:  // Multiplication
+            if (!is_integer(p->tail) || !is_integer(q->tail))
+                continue;
+            break;
+        default:
+            continue;
+        }
+
+        // Replace "p q op" with a single literal
+        Node *value = text(doop(op, *p->tail, *q->tail)); // Literals stay strings
+        if (rfail) {
+            // Overflow or division by zero, leave it to fail when executed
+            rfail = 0;
+            delete_string(value);
+            continue;
+        }
+        delete_string(p->tail);
+        delete_string(q->tail);
+        p->tail = value;
+        p->head = o->head;
+        free_node(*q);
+        free_node(*o);
+        goto again;
+    }
+}
+
 //
 // Parse a pattern (match statement pattern).
 // Handles pattern components, alternation, and grouping.
@@ -442,6 +519,97 @@ merr:
     return *a;
 }
 
+//
+// Check whether an expression list is a single variable reference.
+// Returns the symbol, or nullptr.
+//
+static Node *single_variable(const Node *list)
+{
+    if (list->typ != Token::TOKEN_VARIABLE || list->head->typ != Token::TOKEN_END)
+        return nullptr;
+    return list->tail;
+}
+
+//
+// Check whether an expression list is a single string literal.
+//
+static bool single_literal(const Node *list)
+{
+    return list->typ == Token::TOKEN_STRING && list->head->typ == Token::TOKEN_END;
+}
+
+//
+// Check whether an assignment returns the value of a single call:
+// the success goto is return, the failure goto return or freturn.
+//
+bool SnobolContext::is_tail_call(const Node *value, const Node &g) const
+{
+    const Node *f = g.tail != nullptr ? single_variable(g.tail) : nullptr;
+
+    return value->typ == Token::TOKEN_VARIABLE && value->head->typ == Token::TOKEN_CALL &&
+           value->head->head->typ == Token::TOKEN_END && g.head != nullptr &&
+           single_variable(g.head) == lookret && (f == lookret || f == lookfret);
+}
+
+//
+// Recognize statement shapes that have a fused implementation in execute().
+// Fused statements keep the generic layout, so execute() can fall back
+// to the generic path when a run-time precondition does not hold.
+// Returns the fused statement type, or the statement's own type.
+//
+Token SnobolContext::fuse(const Node &stmt) const
+{
+    const Node *r = stmt.tail;
+    const Node *list, *value;
+    Node *var;
+
+    switch (stmt.typ) {
+    case Token::STMT_ASSIGN: // r a g
+        var   = single_variable(r->tail);
+        value = r->head->tail;
+        if (var == nullptr)
+            break;
+
+        // x = syspit
+        if (single_variable(value) != nullptr &&
+            single_variable(value)->typ == Token::EXPR_SYSPIT)
+            return Token::STMT_READ;
+
+        // syspot = x, syspot = "lit"
+        if (var->typ == Token::EXPR_SYSPOT && (single_variable(value) || single_literal(value)))
+            return Token::STMT_WRITE;
+
+        // f = g(x) /(return), f = g(x) /s(return)f(freturn)
+        if (is_tail_call(value, *r->head->head))
+            return Token::STMT_TAIL;
+
+        // n = n + "k", n = n - "k"
+        list = value;
+        if (list->typ != Token::TOKEN_VARIABLE || list->tail != var)
+            break;
+        list = list->head;
+        if (list->typ != Token::TOKEN_STRING || !is_integer(list->tail))
+            break;
+        list = list->head;
+        if ((list->typ == Token::TOKEN_PLUS || list->typ == Token::TOKEN_MINUS) &&
+            list->head->typ == Token::TOKEN_END)
+            return Token::STMT_INCR;
+        break;
+
+    case Token::STMT_MATCH: // r m g
+        // x "lit"
+        list = r->head->tail;
+        if (single_variable(r->tail) != nullptr && list->typ == Token::TOKEN_UNANCHORED &&
+            single_literal(list->tail) && list->head->typ == Token::TOKEN_END)
+            return Token::STMT_FIND;
+        break;
+
+    default:
+        break;
+    }
+    return stmt.typ;
+}
+
 //
 // Compile a single Snobol statement.
 // Handles labels, assignments, pattern matching, goto statements, and function definitions.
@@ -454,15 +622,17 @@ Node *SnobolContext::compile()
     Token a;
     Node *m, *as;
     Token t;
-
-    m    = nullptr;            // Match pattern
-    l    = nullptr;            // Label
-    as   = nullptr;            // Assignment target
-    xs   = nullptr;            // Success goto
-    xf   = nullptr;            // Failure goto
-    t    = Token::STMT_SIMPLE; // Statement type
-    comp = &compon();
-    a    = comp->typ;
+    bool global;
+
+    m      = nullptr;            // Match pattern
+    l      = nullptr;            // Label
+    as     = nullptr;            // Assignment target
+    xs     = nullptr;            // Success goto
+    xf     = nullptr;            // Failure goto
+    t      = Token::STMT_SIMPLE; // Statement type
+    global = false;              // == after a pattern, see replace_all()
+    comp   = &compon();
+    a      = comp->typ;
     // Check for optional label
     if (a == Token::TOKEN_VARIABLE) {
         l = comp->head;
@@ -501,10 +671,19 @@ Node *SnobolContext::compile()
     return nullptr;
 
 assig:
-    // Parse assignment value
+    // Parse assignment value; == after a pattern replaces every match
     free_node(*comp);
+    b = nullptr;
+    if (m != nullptr) {
+        b = &compon();
+        if (b->typ == Token::TOKEN_EQUALS) {
+            global = true;
+            free_node(*b);
+            b = nullptr;
+        }
+    }
     as   = &alloc();
-    comp = &expr(nullptr, Token::TOKEN_MARKER, *as);
+    comp = &expr(b, Token::TOKEN_MARKER, *as);
     a    = comp->typ;
     if (a == Token::TOKEN_END)
         goto asmble;
@@ -592,6 +771,8 @@ asmble:
     if (m && as) {
         // Pattern replacement: r->head = m, m->head = as, as->head = g
         t       = Token::STMT_REPLACE; // Type 3: pattern replacement
+        if (global)
+            t = Token::STMT_GLOBAL;
         r->head = m;
         m->head = as;
         r       = as; // Set r to as for goto structure linking
@@ -619,10 +800,12 @@ asmble:
     r->head   = g;  // Link goto structure to statement
     comp->typ = t;  // Statement type: 0=simple, 1=match, 2=assign, 3=replace
     comp->ch  = lc; // Store line number
+    if (superinstructions)
+        comp->typ = fuse(*comp);
     return (comp);
 
 def:
-    // Parse function definition: define name(params) body
+    // Parse function definition: define name(params)locals [memo] body
     r = &nscomp();
     if (r->typ != Token::TOKEN_VARIABLE) // Should be function name
         goto derr;
@@ -632,7 +815,9 @@ def:
     l->typ = Token::EXPR_FUNCTION; // type function;
     {
         Node *a_ptr = r;
+        Node *name  = r;
         l->tail     = a_ptr;
+        name->ch    = 0;
         r           = &nscomp();
         l           = r;
         a_ptr->head = l;
@@ -658,6 +843,33 @@ def:
             goto derr;
         free_node(*r);
         r = &compon();
+        if (r->typ != Token::TOKEN_VARIABLE) // No locals
+            goto d3;
+
+    dl:
+        // Parse local variable list, after the parameters
+        a_ptr->tail = r;
+        r->typ      = Token::EXPR_VALUE; // Local, bound to the empty string by calls
+        a_ptr       = r;
+        r           = &compon();
+        if (r->typ == Token::TOKEN_COMMA) { // Comma - more locals
+            free_node(*r);
+            r = &nscomp();
+            if (r->typ != Token::TOKEN_VARIABLE) // Should be local name
+                goto derr;
+            goto dl;
+        }
+
+    d3:
+        if (r->typ == Token::TOKEN_WHITESPACE) {
+            free_node(*r);
+            r = &nscomp();
+            if (r->typ == Token::TOKEN_VARIABLE && r->head == lookmemo) {
+                name->ch = MEMO_FUNCTION; // Cache results, see memoize()
+                free_node(*r);
+                r = &nscomp();
+            }
+        }
         if (r->typ != Token::TOKEN_END) // Should be end of statement
             goto derr;
         free_node(*r);
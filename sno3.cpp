@@ -1,341 +1,724 @@
+#include <algorithm>
+#include <climits>
 #include "sno.h"
 
 //
-// Extend a balanced pattern match (handles nested parentheses).
-// Extends the match position forward while maintaining balanced parentheses.
-// Returns the number of characters matched, or 0 on failure.
+// Get the character after a position of the subject,
+// or null at the end.
 //
-int Node::bextend(const Node *last)
+static Node *after(const Node *r, Node *pos)
 {
-    Node *a, *s;
-    int b;
-    Node *c;
-    int d;
-    CharClass class_val;
-
-    s = this;
-    c = s->head;
-    if (c == nullptr)
-        goto bad;
-    b = 0; // Parenthesis balance counter
-    d = 0; // Character count
-    a = s->tail;
-    if (a == nullptr) {
-        a = c;
-        goto eb2;
+    if (r == nullptr)
+        return nullptr;
+    if (pos == nullptr)
+        return r->head;
+    return pos == r->tail ? nullptr : pos->head;
+}
+
+//
+// Match a string at a position of the subject.
+// Returns false if it does not match, else sets end to the position
+// after it.
+//
+static bool literal(const Node *r, Node *pos, const Node *value, Node *&end)
+{
+    const Node *s;
+
+    if (value == nullptr) {
+        end = pos;
+        return true;
     }
-eb1:
-    if (a == last)
-        goto bad;
-    a = a->head;
-eb2:
-    d++;
-    class_val = SnobolContext::char_class(a->ch);
-    if (class_val == CharClass::RPAREN) { // rp - right parenthesis
-        if (b == 0)
-            goto bad;
-        b--;
-        goto eb3;
+    for (s = value;;) {
+        s   = s->head;
+        pos = after(r, pos);
+        if (pos == nullptr || pos->ch != s->ch)
+            return false;
+        if (s == value->tail)
+            break;
     }
-    if (class_val == CharClass::LPAREN) { // lp - left parenthesis
-        b++;
-        goto eb1;
+    end = pos;
+    return true;
+}
+
+//
+// Find the next occurrence of the value of a simple component at or after
+// a position, with the Boyer-Moore-Horspool method: a window of the
+// length of the value slides over the subject, and the character under
+// its end tells how far it can move without skipping an occurrence.
+// Returns false if there is none, else moves pos to it and adds the
+// distance to length.
+//
+static bool find(const Node *r, const PatternComponent &c, Node *&pos, int &length)
+{
+    const Node *value = c.alt[0];
+    Node *first       = pos;
+    Node *last        = pos;
+    Node *end;
+    int shift;
+
+    for (shift = c.size; shift > 0; shift--) {
+        last = after(r, last);
+        if (last == nullptr)
+            return false;
     }
-eb3:
-    if (b == 0) { // Balanced - found end of pattern
-        s->tail = a;
-        return (d);
+    for (;;) {
+        if (last->ch == value->tail->ch && literal(r, first, value, end)) {
+            pos = first;
+            return true;
+        }
+        shift = c.skip == nullptr ? 1 : (*c.skip)[static_cast<unsigned char>(last->ch)];
+        for (length += shift; shift > 0; shift--) {
+            last = after(r, last);
+            if (last == nullptr)
+                return false;
+            first = after(r, first);
+        }
+    }
+}
+
+//
+// Check whether a string is non-void and balanced with respect
+// to parentheses.
+//
+static bool balanced(const Node *value)
+{
+    const Node *a;
+    int depth = 0;
+
+    if (value == nullptr)
+        return false;
+    for (a = value; a != value->tail;) {
+        a = a->head;
+        switch (SnobolContext::char_class(a->ch)) {
+        case CharClass::LPAREN:
+            depth++;
+            break;
+        case CharClass::RPAREN:
+            if (depth == 0)
+                return false;
+            depth--;
+            break;
+        default:
+            break;
+        }
     }
-    goto eb1;
-bad:
-    return (0);
+    return depth == 0;
 }
 
 //
-// Extend an unbalanced pattern match (simple extension by one character).
-// Advances the match position by one character.
-// Returns 1 on success, 0 on failure.
+// Extend the substring of a balanced string variable by one balanced
+// unit: a character other than a parenthesis, or a parenthesized string,
+// which the index of the subject's parentheses skips in one step.
+// Returns false if it cannot be extended.
 //
-int Node::ubextend(const Node *last)
+static bool bextend(const Node *r, const ParenIndex &parens, MatchChoice &c)
 {
-    Node *a, *b, *s;
+    Node *a = after(r, c.end);
 
-    s = this;
-    a = s->head;
     if (a == nullptr)
-        goto bad;
-    b = s->tail;
-    if (b == nullptr)
-        goto good;
-    if (b == last)
-        goto bad;
-    a = b->head;
-good:
-    s->tail = a;
-    return (1);
-bad:
-    return (0);
+        return false;
+    switch (SnobolContext::char_class(a->ch)) {
+    case CharClass::LPAREN: {
+        auto it = parens.find(a);
+        if (it == parens.end())
+            return false; // Not closed
+        c.end = it->second.first;
+        c.length += it->second.second;
+        return true;
+    }
+    case CharClass::RPAREN:
+        return false;
+    default:
+        c.end = a;
+        c.length++;
+        return true;
+    }
 }
 
 //
-// Search for a pattern match in the subject string.
-// Implements backtracking pattern matching algorithm for Snobol patterns.
-// Returns a match result node on success, NULL on failure.
+// Index the parentheses of a subject for bextend().
 //
-// RETURN VALUE STRUCTURE:
-// When a match is found, search() returns a Node* (typically called 'd' in execute())
-// with the following structure:
+static void index_parens(const Node *r, ParenIndex &parens,
+                         std::vector<std::pair<Node *, int>> &open)
+{
+    Node *a;
+    int n = 0;
+
+    for (a = after(r, nullptr); a != nullptr; a = after(r, a), n++) {
+        switch (SnobolContext::char_class(a->ch)) {
+        case CharClass::LPAREN:
+            open.emplace_back(a, n);
+            break;
+        case CharClass::RPAREN:
+            if (open.empty())
+                break;
+            parens[open.back().first] = { a, n - open.back().second + 1 };
+            open.pop_back();
+            break;
+        default:
+            break;
+        }
+    }
+    open.clear();
+}
+
 //
-//   d->head: Character node BEFORE the match start
-//          - nullptr if match starts at beginning of string
+// Extend the substring of an arbitrary string variable by one character.
+// Returns false at the end of the subject.
 //
-//   d->tail: Character node AFTER the match end
-//          - Points to the character node immediately after the match
-//          - If match ends at end of string: d->tail = r->tail (end marker)
-//          - Otherwise: d->tail = next (character node after match)
+static bool ubextend(const Node *r, MatchChoice &c)
+{
+    Node *a = after(r, c.end);
+
+    if (a == nullptr)
+        return false;
+    c.end = a;
+    c.length++;
+    return true;
+}
+
 //
-// EXAMPLE: For string "hello world" matching "world":
-//   - next = nullptr (match is at end)
-//   - d->head = ' ' (space before "world")
-//   - d->tail = r->tail (end marker, since match ends at end)
+// Measure the value of a simple component and, if it is searched for
+// and long enough to gain from it, build its skip table, see find().
 //
-Node *SnobolContext::search(const Node &arg, Node *r)
+static void prepare(PatternComponent &c, bool searched, std::vector<SkipTable> &skips)
 {
-    Node *list, *back, *str, *etc, *next, *last, *base, *e;
-    Node *a, *b, *var;
-    Token c;
-    Token d_token;
-    int d{}, len;
-    Node *before_match_start = nullptr; // Track node before match_start
-
-    // Initialize pattern matching state
-    a    = arg.tail;        // Start of pattern component list
-    list = base = &alloc(); // Base of matching state list
-    last        = nullptr;  // End of subject string (set later)
-    next        = nullptr;  // Next position to match from
-    goto badv1;
-badvanc:
-    // Build pattern matching state from pattern components
-    a = a->head;
-    if (a->typ == Token::TOKEN_END) {
-        // End of pattern - initialize search
-        list->head = nullptr;
-        if (rfail == 1) {
-            a = nullptr;
-            goto fail;
-        }
-        list = base;
-        if (r == nullptr)
-            next = last = nullptr;
-        else {
-            next               = r->head; // Start of subject string
-            last               = r->tail; // End of subject string
-            before_match_start = nullptr; // Match starts at beginning, nothing before it
+    const Node *a;
+    int n;
+
+    c.size = 0;
+    c.skip = nullptr;
+    if (c.alt[0] == nullptr)
+        return;
+    for (a = c.alt[0]; a != c.alt[0]->tail; a = a->head)
+        c.size++;
+    if (!searched || c.size < 2)
+        return;
+    skips.emplace_back();
+    skips.back().fill(c.size);
+    for (n = 0, a = c.alt[0]->head; n < c.size - 1; n++, a = a->head)
+        skips.back()[static_cast<unsigned char>(a->ch)] = c.size - 1 - n;
+    c.skip = &skips.back();
+}
+
+//
+// Get the length of the shortest subject a pattern can match: the sum of
+// its strings, the shorter alternative of each alternation and one unit
+// for each balanced string variable.
+//
+static int minimum(const PatternComponent *components, size_t count)
+{
+    const Node *a;
+    size_t i;
+    int m = 0;
+    int n, k;
+
+    for (i = 0; i < count; i++) {
+        const PatternComponent &c = components[i];
+        switch (c.kind) {
+        case PatternKind::SIMPLE:
+            m += c.size;
+            break;
+        case PatternKind::VARIABLE:
+            if (c.balanced)
+                m++;
+            break;
+        case PatternKind::ALTERNATION:
+            n = INT_MAX;
+            for (k = 0; k < 2; k++) {
+                int size = 0;
+                if (c.alt[k] != nullptr)
+                    for (a = c.alt[k]; a != c.alt[k]->tail; a = a->head)
+                        size++;
+                n = std::min(n, size);
+            }
+            m += n;
+            break;
         }
-        goto adv1;
     }
-    b          = &alloc();
-    list->head = b;
-    list       = b;
-badv1:
-    // Set up backtracking structure for this pattern component
-    list->tail = back = &alloc();
-    back->head        = last;
-    b                 = a->tail;
-    c                 = a->typ;
-    list->typ         = c;
-    if (c == Token::TOKEN_ALTERNATION) {
-        mes("alternations are not supported yet");
-        return nullptr;
-    }
-    if (c < Token::TOKEN_ALTERNATION) {
-        // Simple pattern component - evaluate and store
-        back->tail = eval(*b, 1);
-        goto badvanc;
+    return m;
+}
+
+//
+// Advance a position of the subject by n characters.
+// Returns false if the subject ends first.
+//
+static bool skip(const Node *r, Node *&pos, int n)
+{
+    for (; n > 0; n--) {
+        pos = after(r, pos);
+        if (pos == nullptr)
+            return false;
     }
-    // Complex pattern component - set up match state
-    last       = list;
-    str        = &alloc(); // Match position tracker
-    etc        = &alloc(); // Pattern metadata
-    back->tail = var = &alloc();
-    var->typ         = b->typ; // Pattern type (1=balanced, 2=unbalanced, 3=concatenated)
-    var->head        = str;
-    var->tail        = etc;
-    e                = b->head;
-    if (e == nullptr)
-        etc->head = nullptr; // No left side
-    else
-        etc->head = eval(*e, 0); // Evaluate left pattern
-    e = b->tail;
-    if (e == nullptr)
-        etc->tail = nullptr; // No right side
-    else {
-        e         = eval(*e, 1);             // Evaluate right pattern (length)
-        etc->tail = (Node *)(long)strbin(e); // Store as integer
-        delete_string(e);
+    return true;
+}
+
+//
+// Check whether the string variable at index i skips to the string after
+// it. Only an arbitrary string variable followed by a non-void string does.
+//
+static bool seeks(const PatternComponent *components, size_t i)
+{
+    return components[i].seek && components[i + 1].alt[0] != nullptr;
+}
+
+//
+// Check whether the simple component at index i is searched for, rather
+// than matched in place: it leads the pattern or follows a string variable
+// that skips to it.
+//
+static bool searched(const PatternComponent *components, size_t i)
+{
+    return i == 0 || components[i - 1].seek;
+}
+
+//
+// Check whether an expression list is a single string literal.
+//
+static bool single_literal(const Node *list)
+{
+    return list->typ == Token::TOKEN_STRING && list->head->typ == Token::TOKEN_END;
+}
+
+//
+// Match alternative c.alternative of an alternation, or the next ones.
+// Returns false when none is left.
+//
+static bool alternate(const Node *r, const PatternComponent &comp, MatchChoice &c)
+{
+    for (; c.alternative < 2; c.alternative++) {
+        const Node *value = comp.alt[c.alternative];
+        if (comp.balanced && !balanced(value))
+            continue;
+        if (literal(r, c.start, value, c.end))
+            return true;
     }
-    goto badvanc;
-
-retard:
-    // Backtrack to previous pattern component
-    a = back->head;
-    if (a == nullptr) {
-        // No previous pattern component - try next position in subject for unanchored search
-        if (next == nullptr || next == last) {
-            rfail = 1;
-            goto fail;
+    return false;
+}
+
+//
+// Compile a pattern on its first search: string literals and target
+// variables are taken from the pattern as they are, and constant strings
+// get their skip tables. Other expressions are left for search() to
+// evaluate each time.
+//
+CompiledPattern &SnobolContext::compile_pattern(const Node &arg)
+{
+    auto found = patterns.find(&arg);
+    if (found != patterns.end())
+        return found->second;
+
+    CompiledPattern &pattern = patterns[&arg];
+    const Node *list, *b, *e;
+    size_t i;
+    int k;
+
+    pattern.dynamic    = false;
+    pattern.backtracks = false;
+    pattern.balanced   = false;
+    for (list = arg.tail; list->typ != Token::TOKEN_END; list = list->head) {
+        b = list->tail;
+        PatternComponent c{ PatternKind::SIMPLE, false, false, { nullptr, nullptr }, nullptr,
+                            { nullptr, nullptr }, false, 0, nullptr };
+        if (list->typ == Token::TOKEN_UNANCHORED) {
+            c.expr[0] = b;
+        } else if (b->tail != nullptr) {
+            c.kind    = PatternKind::ALTERNATION;
+            c.expr[0] = b->head;
+            c.expr[1] = b->tail;
+        } else {
+            c.kind = PatternKind::VARIABLE;
+            e      = b->head;
+            if (e != nullptr && e->typ == Token::TOKEN_VARIABLE &&
+                e->head->typ == Token::TOKEN_END)
+                c.target = e->tail;
+            else
+                c.expr[0] = e;
         }
+        if (list->typ != Token::TOKEN_UNANCHORED)
+            c.balanced = b->typ == Token::STMT_MATCH;
+        for (k = 0; k < 2; k++) {
+            e = c.expr[k];
+            if (e == nullptr)
+                continue;
+            if (c.kind != PatternKind::VARIABLE && single_literal(e)) {
+                c.alt[k]  = text(e->tail);
+                c.expr[k] = nullptr;
+                continue;
+            }
+            c.dynamic       = true;
+            pattern.dynamic = true;
+        }
+        pattern.components.push_back(c);
+    }
 
-        // Advance to next position and try again
-        before_match_start = next; // Current next will be before the new match_start
-        next               = next->head;
-        list               = base;
-        goto adv1;
+    // Skip tables of constant strings; reserved so they do not move
+    pattern.skips.reserve(pattern.components.size());
+    k = 0;
+    for (i = 0; i < pattern.components.size(); i++) {
+        PatternComponent &c = pattern.components[i];
+        if (c.kind != PatternKind::SIMPLE && k++ != 0)
+            pattern.backtracks = true;
+        if (c.kind == PatternKind::VARIABLE && c.balanced)
+            pattern.balanced = true;
+        if (c.kind == PatternKind::VARIABLE && !c.balanced && i + 1 < pattern.components.size() &&
+            pattern.components[i + 1].kind == PatternKind::SIMPLE)
+            c.seek = true;
+        if (c.kind == PatternKind::SIMPLE && !c.dynamic)
+            prepare(c, searched(pattern.components.data(), i), pattern.skips);
     }
-    list = a;
-    back = list->tail;
-    var  = back->tail;
-    str  = var->head;
-    etc  = var->tail;
-    if (etc->tail) // Has length constraint - need to retry
-        goto retard;
-
-    // Try to extend current match
-    if (var->typ == Token::TOKEN_UNANCHORED) { // Balanced pattern (value 1)
-        if (str->bextend(last) == 0)
-            goto retard;
-        goto adv0;
+    pattern.minimum = minimum(pattern.components.data(), pattern.components.size());
+    return pattern;
+}
+
+//
+// Count a backtracking step of a match. Returns false, and counts the
+// match in match_aborts, when the match or the statement it belongs to
+// goes over max_steps; search() then fails. The steps of a statement
+// include all its searches and those of the functions they call, see
+// perform(). Checks the time limit every 1024 steps.
+//
+bool SnobolContext::spend(uint64_t &steps)
+{
+    steps++;
+    statement_steps++;
+    if (time_limit > 0 && (steps & 1023) == 0)
+        check_deadline();
+    if (max_steps != 0 && (steps > max_steps || statement_steps > max_steps)) {
+        match_aborts++;
+        return false;
     }
-    if (str->ubextend(last) == 0) // Unbalanced pattern
-        goto retard;
-adv0:
-    // Advance to next position
-    a = str->tail;
-adv01:
-    if (a == last)
-        next = nullptr;
-    else
-        next = a->head;
-advanc:
-    // Process next pattern component
-    a = list->head;
-    if (a == nullptr) {
-        // End of pattern - check if match succeeded
-        a = &alloc();
-        if (r == nullptr) {
-            a->head = a->tail = nullptr;
-            goto fail;
-        }
+    return true;
+}
+
+//
+// Search for a pattern match in the subject string r.
+// Implements the scanning rules of Snobol III:
+//
+// 1. The match is tried at the first character of the subject,
+//    then at each following one. Positions where a leading string
+//    cannot start are skipped.
+// 2. Components are matched left to right, each to the shortest
+//    substring it accepts, an alternation to its first alternative.
+// 3. When a component cannot match, the last string variable or
+//    alternation before it takes its next acceptable substring: the
+//    string variable is extended, the alternation tries its second
+//    alternative. Matching goes on after it. When there is none,
+//    rule 1 applies.
+// 4. An arbitrary string variable that ends the pattern extends to
+//    the end of the subject.
+//
+// No match is tried where the rest of the subject is shorter than the
+// pattern's minimum length: a position that many characters ahead of
+// the start moves along with it.
+//
+// Choice points are kept on an explicit stack, not the C++ stack.
+// On success the string variables are assigned their substrings.
+//
+// Since nothing is assigned before success, whether the components
+// from i on can match from a position does not depend on how the match
+// got there. With several choice points, the states that failed are
+// remembered and not tried again, so that adjacent string variables
+// cannot take exponential time.
+// A pattern without dynamic components allocates nothing but the
+// result node.
+//
+// Returns a node with head the character before the match (nullptr if
+// it starts the subject) and tail the character after the match
+// (nullptr if it ends the subject), or NULL if there is no match.
+//
+Node *SnobolContext::search(const Node &arg, Node *r)
+{
+    CompiledPattern &pattern = compile_pattern(arg);
+    const PatternComponent *components;
+    size_t count = pattern.components.size();
+    size_t base  = match_components.size(); // Of this search, see below
+    size_t skips = match_skips.size();
+    Node *start, *pos, *a, *e, *v;
+    Node *last    = nullptr; // Minimum characters after start
+    Node *d       = nullptr;
+    bool first    = false; // Leading string, see rule 1
+    bool anchored = false; // Leading arbitrary string variable
+    bool placed;
+    uint64_t steps = 0; // See spend()
+    int length     = pattern.minimum;
+    int n;
+    size_t i;
 
-        // Set a->head to character BEFORE match start (or nullptr if match at start)
-        a->head = before_match_start;
+    matching++; // Calls made from here count toward the statement, see perform()
 
-        // Set a->tail to character AFTER match end (or r->tail if match at end)
-        if (next == nullptr) {
-            // Match ends at end of string
-            a->tail = r->tail;
-        } else {
-            // next points to character after match end
-            a->tail = next;
+    // Evaluate the dynamic components, left to right, into the match
+    // state of the context. eval() may call a function that searches
+    // in turn, so the state is a stack and only indexed while it runs.
+    if (pattern.dynamic) {
+        match_components.insert(match_components.end(), pattern.components.begin(),
+                                pattern.components.end());
+        for (i = 0; i < count; i++) {
+            if (!match_components[base + i].dynamic)
+                continue;
+            for (n = 0; n < 2; n++) {
+                const Node *expr = match_components[base + i].expr[n];
+                if (expr == nullptr)
+                    continue;
+                if (match_components[base + i].kind == PatternKind::VARIABLE) {
+                    v = eval(*const_cast<Node *>(expr), 0);
+                    match_components[base + i].target = v;
+                } else {
+                    v = text(eval(*const_cast<Node *>(expr), 1));
+                    match_components[base + i].alt[n] = v;
+                }
+            }
         }
-        goto fail;
+        components = &match_components[base];
+        match_skips.reserve(skips + count);
+        for (i = 0; i < count; i++)
+            if (components[i].kind == PatternKind::SIMPLE && components[i].dynamic)
+                prepare(match_components[base + i], searched(components, i), match_skips);
+        length = minimum(components, count);
+    } else {
+        components = pattern.components.data();
     }
-    list = a;
-adv1:
-    back    = list->tail;
-    var     = back->tail;
-    d_token = list->typ;
-    if (d_token < Token::TOKEN_ALTERNATION) {
-        // Simple pattern - match string directly
-        if (var == nullptr)
-            goto advanc;
-        if (next == nullptr)
-            goto retard;
-        a = next;
-        b = var->head;
-        e = var->tail;
-        while (1) {
-            if (a->ch != b->ch)
-                goto retard;
-            if (b == e) // Matched entire string
-                goto adv01;
-            if (a == last) // Reached end of subject
-                goto retard;
-            a = a->head;
-            b = b->head;
-        }
+    if (rfail == 1)
+        goto done;
+    if (!skip(r, last, length))
+        goto done; // Subject too short
+    if (pattern.balanced)
+        index_parens(r, match_parens, match_open);
+
+    // A leading arbitrary string variable can absorb any prefix,
+    // so if the match fails at the start it fails everywhere
+    if (count != 0) {
+        first    = components[0].kind == PatternKind::SIMPLE && components[0].alt[0] != nullptr;
+        anchored = components[0].kind == PatternKind::VARIABLE && !components[0].balanced;
     }
-    // Complex pattern - handle alternation or concatenation
-    str       = var->head;
-    etc       = var->tail;
-    str->head = next;
-    str->tail = nullptr;
-    len       = (long)etc->tail;               // Length constraint
-    if (var->typ == Token::TOKEN_UNANCHORED) { // Balanced pattern (value 1)
-        d = str->bextend(last);
-        if (d == 0)
-            goto retard;
-        if (len == 0) // No length constraint
-            goto adv0;
-        // Match with length constraint
-        while (1) {
-            len = -d;
-            if (len == 0)
-                goto adv0;
-            if (len < 0)
-                goto retard;
-            d = str->bextend(last);
-            if (d == 0)
-                goto retard;
+
+    start = nullptr;
+    for (;;) {
+        // Rule 1: match from start
+        if (!spend(steps))
+            break;
+        n = 0;
+        if (first && !(find(r, components[0], start, n) && skip(r, last, n)))
+            break;
+        match_choices.clear();
+        pos = start;
+        i   = 0;
+    advance:
+        for (; i < count; i++) {
+            const PatternComponent &c = components[i];
+            if (c.kind == PatternKind::SIMPLE) {
+                if (!literal(r, pos, c.alt[0], pos))
+                    goto retreat;
+                continue;
+            }
+            MatchChoice ch{ i, pos, pos, 0, 0 };
+            if (pattern.backtracks && match_failed.count({ i, pos }) != 0)
+                goto retreat;
+            if (c.kind == PatternKind::ALTERNATION) {
+                placed = alternate(r, c, ch);
+            } else if (c.balanced) {
+                placed = bextend(r, match_parens, ch);
+            } else if (seeks(components, i)) {
+                placed = find(r, components[i + 1], ch.end, ch.length);
+            } else {
+                placed = true;
+                if (i + 1 == count) {
+                    // Rule 4
+                    while (ubextend(r, ch))
+                        ;
+                }
+            }
+            if (!placed) {
+                if (pattern.backtracks)
+                    match_failed.insert({ i, pos });
+                goto retreat;
+            }
+            match_choices.push_back(ch);
+            pos = ch.end;
+        }
+
+        // Matched: assign the string variables
+        for (MatchChoice &ch : match_choices) {
+            const PatternComponent &c = components[ch.component];
+            if (c.target == nullptr)
+                continue;
+            a = nullptr;
+            if (ch.length != 0) {
+                e       = &alloc();
+                e->head = after(r, ch.start);
+                e->tail = ch.end;
+                a       = copy(e);
+                free_node(*e);
+            }
+            assign(*c.target, *a);
         }
+        d       = &alloc();
+        d->head = start;
+        d->tail = after(r, pos);
+        goto done;
+
+    retreat:
+        // Rule 3: take the next substring of the last choice that has one
+        while (!match_choices.empty()) {
+            if (!spend(steps))
+                goto done;
+            MatchChoice &ch           = match_choices.back();
+            const PatternComponent &c = components[ch.component];
+            bool next;
+            if (c.kind == PatternKind::ALTERNATION) {
+                ch.alternative++;
+                next = alternate(r, c, ch);
+            } else if (c.balanced) {
+                next = bextend(r, match_parens, ch);
+            } else if (seeks(components, ch.component)) {
+                next = ubextend(r, ch) &&
+                       find(r, components[ch.component + 1], ch.end, ch.length);
+            } else {
+                next = ch.component + 1 != count && ubextend(r, ch);
+            }
+            if (next) {
+                pos = ch.end;
+                i   = ch.component + 1;
+                goto advance;
+            }
+            if (pattern.backtracks)
+                match_failed.insert({ ch.component, ch.start });
+            match_choices.pop_back();
+        }
+        if (anchored)
+            break;
+        start = after(r, start);
+        if (start == nullptr || (length != 0 && !skip(r, last, 1)))
+            break;
     }
-    if (len == 0) {                      // No length constraint
-        if (d == 3 && next != nullptr) { // Concatenated pattern
-            str->tail = last;
-            goto adv0;
+
+done:
+    // Pop the match state of this search
+    for (i = base; i < match_components.size(); i++) {
+        PatternComponent &c = match_components[i];
+        if (c.dynamic && c.kind != PatternKind::VARIABLE) {
+            delete_string(c.expr[0] != nullptr ? c.alt[0] : nullptr);
+            delete_string(c.expr[1] != nullptr ? c.alt[1] : nullptr);
         }
-        goto advanc;
     }
+    match_components.resize(base);
+    match_skips.resize(skips);
+    match_choices.clear();
+    if (!match_failed.empty())
+        match_failed.clear();
+    if (!match_parens.empty())
+        match_parens.clear();
+    matching--;
+    return (d);
+}
 
-    // Match with specific length
-    while (len--)
-        if (str->ubextend(last) == 0)
-            goto retard;
-    goto adv0;
-
-fail:
-    // Cleanup and assign matched substrings to variables
-    list = base;
-    goto f1;
-fadv:
-    free_node(*back);
-    b = list->head;
-    free_node(*list);
-    if (b == nullptr)
-        return (a);
-    list = b;
-f1:
-    back = list->tail;
-    var  = back->tail;
-    if (list->typ < Token::TOKEN_ALTERNATION) {
-        // Simple pattern - no assignment needed
-        delete_string(var);
-        goto fadv;
+//
+// Add the characters first to last of a string to the end of a result.
+//
+static void append(SnobolContext &ctx, Node *&result, Node *first, Node *last)
+{
+    if (result == nullptr) {
+        result       = &ctx.alloc();
+        result->head = first;
+    } else {
+        result->tail->head = first;
     }
-    // Complex pattern - assign matched substring
-    str = var->head;
-    etc = var->tail;
-    if (a != nullptr && etc->head != nullptr) {
-        // Assign matched substring to variable
-        if (str->tail == nullptr) {
-            free_node(*str);
-            str = nullptr;
+    result->tail = last;
+}
+
+//
+// Replace every match of a pattern in the string r with the value of an
+// expression, in one pass from left to right: each search starts where
+// the previous match ended, and the value is evaluated after each match,
+// so it sees the string variables the match assigned. An empty match
+// keeps the character after it, so the scan moves on. Once the subject
+// is used up the pattern is tried once more on the empty rest, unless an
+// empty match was just found there, so that the end is a match position
+// like any other. The characters of r that are not matched are linked
+// into the result as they are, and so are the values; r is taken over.
+// Returns false, having deleted r, if nothing matches, a search runs out
+// of steps (see spend()) or the replacement fails, else sets result.
+//
+bool SnobolContext::replace_all(const Node &arg, const Node &value, Node *r, Node *&result)
+{
+    Node *d, *a, *b, *c, *s, *next;
+    size_t aborts = match_aborts;
+    bool matched  = false;
+    bool rest     = r != nullptr; // Characters left after the last match
+    bool end      = !rest;        // Matching the empty rest at the end
+    bool empty;
+
+    result = nullptr;
+    matching++;
+    for (;;) {
+        s = end ? nullptr : r; // Subject of this search
+        d = search(arg, s);
+        if (d == nullptr) {
+            if (match_aborts != aborts) {
+                // Out of steps: drop what was replaced
+                matched = false;
+                delete_string(result);
+                result = nullptr;
+            }
+            break;
+        }
+        matched = true;
+        next    = d->tail;
+        empty   = after(s, d->head) == next;
+
+        // Keep the characters before the match, drop the matched ones
+        if (d->head != nullptr)
+            append(*this, result, r->head, d->head);
+        for (a = after(s, d->head); a != next; a = b) {
+            b = after(s, a);
+            free_node(*a);
+        }
+        free_node(*d);
+        c = text(eval(const_cast<Node &>(value), 1));
+        if (rfail == 1) {
+            // Drop the result and the rest of the subject
+            delete_string(c);
+            delete_string(result);
+            result = nullptr;
+            if (next != nullptr) {
+                r->head = next;
+                delete_string(r);
+            } else if (r != nullptr) {
+                free_node(*r);
+            }
+            matching--;
+            return false;
+        }
+        if (c != nullptr) {
+            append(*this, result, c->head, c->tail);
+            free_node(*c);
+        }
+        if (next == nullptr && (end || empty)) {
+            rest = false;
+            break; // The end was matched
+        }
+        if (empty) {
+            append(*this, result, next, next);
+            next = after(r, next);
         }
-        assign(*etc->head, *copy(str));
+        if (next == nullptr) {
+            rest = false;
+            end  = true;
+        } else {
+            r->head = next;
+        }
+    }
+    matching--;
+    if (!matched) {
+        if (rest)
+            delete_string(r);
+        else if (r != nullptr)
+            free_node(*r);
+        return false;
     }
-    if (str)
-        free_node(*str);
-    free_node(*etc);
-    free_node(*var);
-    goto fadv;
+    if (rest)
+        append(*this, result, r->head, r->tail);
+    if (r != nullptr)
+        free_node(*r);
+    return true;
 }
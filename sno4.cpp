@@ -1,13 +1,162 @@
 #include <iostream>
+#include <iterator>
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#endif
 
 #include "sno.h"
 
+//
+// The evaluator and the statement executor dispatch through tables of label
+// addresses when the compiler supports computed goto (GCC and Clang).
+// Each handler then ends with its own indirect jump, which the branch
+// predictor can track separately. Define SNO_NO_COMPUTED_GOTO to build
+// the portable switch-based dispatch instead.
+// Labels as values are a GNU extension, so -Wpedantic is turned off
+// around the tables and the jumps only.
+//
+#if defined(__GNUC__) && !defined(SNO_NO_COMPUTED_GOTO)
+#define SNO_COMPUTED_GOTO 1
+#else
+#define SNO_COMPUTED_GOTO 0
+#endif
+
+#if SNO_COMPUTED_GOTO
+#define COMPUTED_GOTO(target)                            \
+    do {                                                 \
+        _Pragma("GCC diagnostic push")                   \
+        _Pragma("GCC diagnostic ignored \"-Wpedantic\"") \
+        goto *(target);                                  \
+        _Pragma("GCC diagnostic pop")                    \
+    } while (0)
+#define EVAL_DISPATCH() COMPUTED_GOTO(targets[eval_slot(list->typ)])
+#define EVAL_NEXT()        \
+    do {                   \
+        list = list->head; \
+        EVAL_DISPATCH();   \
+    } while (0)
+#else
+#define EVAL_DISPATCH() goto dispatch
+#define EVAL_NEXT() goto advanc
+#endif
+
+//
+// Map an expression token to its slot in the evaluator dispatch table.
+// Anything out of range terminates the expression, like TOKEN_END.
+//
+static inline unsigned eval_slot(Token op)
+{
+    unsigned slot = static_cast<unsigned>(op);
+
+    return (slot <= static_cast<unsigned>(Token::TOKEN_INT_CAT)) ? slot : 0;
+}
+
+//
+// Map a specialised arithmetic operator back to the generic one.
+//
+static inline Token generic_op(Token op)
+{
+    switch (op) {
+    case Token::TOKEN_INT_PLUS:
+        return Token::TOKEN_PLUS;
+    case Token::TOKEN_INT_MINUS:
+        return Token::TOKEN_MINUS;
+    case Token::TOKEN_INT_MULT:
+        return Token::TOKEN_MULT;
+    case Token::TOKEN_INT_DIV:
+        return Token::TOKEN_DIV;
+    case Token::TOKEN_INT_CAT:
+        return Token::TOKEN_WHITESPACE;
+    default:
+        return op;
+    }
+}
+
+//
+// Map a statement type to its slot in the executor dispatch table.
+// Types below STMT_SIMPLE wrap around to slots past the end of the table.
+//
+static inline unsigned stmt_slot(Token typ)
+{
+    return static_cast<unsigned>(typ) - static_cast<unsigned>(Token::STMT_SIMPLE);
+}
+
+//
+// Where a statement left at a function call continues, see perform().
+//
+enum Step {
+    STEP_SIMPLE = 1,     // Subject of a simple statement
+    STEP_MATCH,          // Subject of a match
+    STEP_ASSIGN_TARGET,  // Target of an assignment
+    STEP_ASSIGN_VALUE,   // Value of an assignment
+    STEP_REPLACE_TARGET, // Subject of a replacement
+    STEP_REPLACE_VALUE,  // Value of a replacement
+    STEP_GOTO,           // Goto, see jump()
+};
+
+//
+// Kinds of tail call, see reuse().
+//
+enum TailCall {
+    TAIL_NONE,    // Not a tail call
+    TAIL_FRETURN, // Failure of the call fails the function
+    TAIL_RETURN,  // Failure of the call returns the function's value
+};
+
+//
+// Check whether a symbol holds a plain string value,
+// so fused statements may read or replace it directly.
+//
+static inline bool is_plain(const Node &var)
+{
+    return var.typ == Token::EXPR_VALUE || var.typ == Token::EXPR_VAR_REF;
+}
+
+//
+// Check whether a symbol is an integer-only variable holding a binary
+// integer, see infer(). Its value is formatted into a temporary string
+// instead of in place, so arithmetic can keep using the binary form.
+//
+static inline bool is_binary(const Node &var)
+{
+    return var.ch == SnobolContext::INTEGER_VARIABLE && var.tail != nullptr &&
+           var.tail->typ == Token::EXPR_INTEGER;
+}
+
+//
+// Check whether a string contains a literal anywhere, like a match
+// statement whose pattern is a single literal. Both may be empty (nullptr).
+//
+static bool contains(const Node *subject, const Node *lit)
+{
+    const Node *start, *a, *b;
+
+    if (lit == nullptr)
+        return true;
+    if (subject == nullptr)
+        return false;
+    for (start = subject->head;; start = start->head) {
+        a = start;
+        b = lit->head;
+        while (a->ch == b->ch) {
+            if (b == lit->tail)
+                return true;
+            if (a == subject->tail)
+                return false;
+            a = a->head;
+            b = b->head;
+        }
+        if (start == subject->tail)
+            return false;
+    }
+}
+
 //
 // Evaluate an operand from the evaluation stack.
 // Handles variable references, function calls, and special values.
 // Returns the value as a string node.
 //
-Node *SnobolContext::eval_operand(Node &ptr)
+Node *SnobolContext::eval_operand(const Operand &ptr)
 {
     Node *a = ptr.head;
 
@@ -35,171 +184,408 @@ Node *SnobolContext::eval_operand(Node &ptr)
     return (a);
 }
 
+//
+// Get an operand of specialised arithmetic as a number, reading a
+// variable without copying its value. The digits of an integer-only
+// variable are replaced by a binary integer, see infer().
+// Returns false, with rfail clear, when the generic path must be taken:
+// for functions and syspit, or when the number does not fit in 64 bits.
+//
+bool SnobolContext::int_operand(const Operand &ptr, int64_t &n)
+{
+    Node *a = ptr.head;
+
+    if (ptr.typ == Token::EXPR_VAR_REF) {
+        if (!is_plain(*a))
+            return false;
+        n = strbin(a->tail);
+        if (rfail) {
+            rfail = 0;
+            return false;
+        }
+        if (a->ch == INTEGER_VARIABLE && a->tail != nullptr &&
+            a->tail->typ != Token::EXPR_INTEGER) {
+            delete_string(a->tail);
+            a->tail = &integer(n);
+        }
+        return true;
+    }
+    n = strbin(a);
+    if (rfail) {
+        rfail = 0;
+        return false;
+    }
+    return true;
+}
+
+//
+// Get an operand of concatenation as a string of its own.
+// A binary integer in a variable is formatted directly, without
+// copying the value first.
+//
+Node *SnobolContext::text_operand(const Operand &ptr)
+{
+    if (ptr.typ == Token::EXPR_VAR_REF && is_plain(*ptr.head) && ptr.head->tail != nullptr &&
+        ptr.head->tail->typ == Token::EXPR_INTEGER)
+        return (&binstr(strbin(ptr.head->tail)));
+    return (text(eval_operand(ptr)));
+}
+
 //
 // Evaluate an expression tree using postfix evaluation.
 // Processes operators and operands from the compiled expression.
+// Operands live on the context's operand stack above the base
+// it had on entry, so nested calls share one stack; so do the
+// arguments of calls, which are evaluated in the same loop.
+// Every handler ends with its own dispatch on the next list node,
+// see EVAL_NEXT() above.
+// When suspend_calls is set, a call leaves the expression on its frame
+// with suspended set, and run() continues it when the function returns.
 // Returns the result as a string node.
 //
 Node *SnobolContext::eval(Node &e, int t)
 {
-    Node *list, *a3, *a4, *a3base;
-    Node *a1, *stack;
-    Token op;
-    Node *a2;
+    Node *list, *a3;
+    Node *a1, *a2;
+    size_t base, top, pending;
+    int64_t n1, n2, n;
+    int tail, cached;
+    bool defer, memo;
+
+#if SNO_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    // Indexed by expression token value
+    static void *const targets[] = {
+        &&op_end,     // TOKEN_END
+        &&op_end,     // TOKEN_UNANCHORED
+        &&op_end,     // TOKEN_ALTERNATION
+        &&op_end,     // TOKEN_EQUALS
+        &&op_end,     // TOKEN_COMMA
+        &&op_end,     // TOKEN_RPAREN
+        &&op_end,     // TOKEN_MARKER
+        &&op_binary,  // TOKEN_WHITESPACE
+        &&op_binary,  // TOKEN_PLUS
+        &&op_binary,  // TOKEN_MINUS
+        &&op_binary,  // TOKEN_MULT
+        &&op_binary,  // TOKEN_DIV
+        &&op_dollar,  // TOKEN_DOLLAR
+        &&op_call,    // TOKEN_CALL
+        &&op_var,     // TOKEN_VARIABLE
+        &&op_string,  // TOKEN_STRING
+        &&op_end,     // TOKEN_LPAREN
+        &&op_integer, // TOKEN_INT_PLUS
+        &&op_integer, // TOKEN_INT_MINUS
+        &&op_integer, // TOKEN_INT_MULT
+        &&op_integer, // TOKEN_INT_DIV
+        &&op_concat,  // TOKEN_INT_CAT
+    };
+#pragma GCC diagnostic pop
+#endif
+
+    defer         = suspend_calls;
+    suspend_calls = false;
+    tail          = tail_call;
+    tail_call     = TAIL_NONE;
+    if (resuming) {
+        // Continue after the call that suspended the expression
+        resuming = false;
+        base     = frames.back().base;
+        pending  = frames.back().calls;
+        t        = frames.back().mode;
+        goto op_return;
+    }
 
     // Postfix expression evaluation using a stack
     if (rfail == 1)
         return (nullptr);
-    stack = nullptr; // Evaluation stack: holds operands and operators
-    list  = &e;      // Current position in expression list
-    goto l1;
+    base    = operands.size(); // Operands of enclosing evaluations stay below
+    pending = calls.size();    // And so do their calls
+    list    = &e;              // Current position in expression list
+#if SNO_COMPUTED_GOTO
+    EVAL_DISPATCH();
+#else
+    goto dispatch;
 advanc:
     list = list->head;
-l1:
-    op = list->typ;
-    switch (op) {
+dispatch:
+    switch (list->typ) {
+    case Token::TOKEN_DOLLAR:
+        goto op_dollar;
+    case Token::TOKEN_CALL:
+        goto op_call;
+    case Token::TOKEN_DIV:
+    case Token::TOKEN_MULT:
+    case Token::TOKEN_MINUS:
+    case Token::TOKEN_PLUS:
+    case Token::TOKEN_WHITESPACE:
+        goto op_binary;
+    case Token::TOKEN_INT_PLUS:
+    case Token::TOKEN_INT_MINUS:
+    case Token::TOKEN_INT_MULT:
+    case Token::TOKEN_INT_DIV:
+        goto op_integer;
+    case Token::TOKEN_INT_CAT:
+        goto op_concat;
+    case Token::TOKEN_STRING:
+        goto op_string;
+    case Token::TOKEN_VARIABLE:
+        goto op_var;
     default:
-    case Token::TOKEN_END: // End of expression
-        if (t == 1) {
-            // Return value mode
-            a1 = eval_operand(*stack);
-            goto e1;
+        goto op_end;
+    }
+#endif
+
+op_end: // End of expression
+    if (calls.size() > pending)
+        goto op_arg;
+    if (operands.size() != base + 1) {
+        writes("phase error");
+        operands.resize(base);
+        return (nullptr);
+    }
+    if (t == 1) {
+        // Return value mode
+        a1 = eval_operand(operands.back());
+        goto e1;
+    }
+    // Assignment mode - get variable reference
+    if (operands.back().typ == Token::EXPR_VALUE)
+        writes("attempt to store in a value");
+    a1 = operands.back().head;
+e1:
+    operands.pop_back();
+    return (a1);
+
+op_dollar: // Pattern immediate value ($)
+    a1 = eval_operand(operands.back());
+    a2 = &look(*text(a1)); // Look up variable
+    delete_string(a1);
+    operands.back() = { a2, Token::EXPR_VAR_REF }; // Mark as variable reference
+    EVAL_NEXT();
+
+op_call: // Function call
+    if (rfail)
+        goto op_fail;
+    if (operands.size() == base || operands.back().typ != Token::EXPR_VAR_REF)
+        writes("illegal function");
+    top = operands.size() - 1; // Stays valid while the arguments grow the stack
+    a1  = operands[top].head;
+    if (!a1 || a1->typ != Token::EXPR_FUNCTION)
+        writes("illegal function");
+    a2 = a1->tail->head; // Definition: head is function body, tail is return value
+    calls.push_back({ list, a1->tail->tail, list->tail, bindings.size(), top });
+    bindings.push_back({ a1, a2->tail, Token::EXPR_FUNCTION }); // Save return value
+    a2->tail = nullptr;
+op_bind: // Match parameters to arguments
+    {
+        PendingCall &c = calls.back();
+        for (; c.arg == nullptr && c.param != nullptr && c.param->typ == Token::EXPR_VALUE;
+             c.param = c.param->tail) {
+            // Locals start out empty
+            a2 = c.param->head;
+            if (!is_plain(*a2))
+                writes("illegal local");
+            bindings.push_back({ a2, a2->tail, a2->typ });
+            a2->typ  = Token::EXPR_VALUE;
+            a2->tail = nullptr;
+        }
+        if (c.param == nullptr || c.arg == nullptr || c.param->typ == Token::EXPR_VALUE) {
+            if (c.param != c.arg)
+                writes("parameters do not match");
+            goto op_invoke;
         }
-        // Assignment mode - get variable reference
-        if (stack->typ == Token::EXPR_VALUE)
-            writes("attempt to store in a value");
-        a1 = stack->head;
-    e1:
-        stack = pop(stack);
-        if (stack)
+        list = c.arg->tail; // Evaluate the argument, see op_arg
+    }
+    EVAL_DISPATCH();
+
+op_arg: // End of an argument: bind it to its parameter
+    {
+        PendingCall &c = calls.back();
+        if (operands.size() != c.top + 2)
             writes("phase error");
-        return (a1);
-    case Token::TOKEN_DOLLAR: // Pattern immediate value ($)
-        a1          = eval_operand(*stack);
-        stack->head = &look(*a1); // Look up variable
-        delete_string(a1);
-        stack->typ = Token::EXPR_VAR_REF; // Mark as variable reference
-        goto advanc;
-    case Token::TOKEN_CALL: // Function call
-        if (!stack || stack->typ != Token::EXPR_VAR_REF)
-            writes("illegal function");
-        a1 = stack->head;
-        // If a1 is a variable node (TOKEN_VARIABLE), follow head to get the symbol
-        if (a1->typ == Token::TOKEN_VARIABLE) {
-            a1 = a1->head;
+        a1 = eval_operand(operands.back());
+        operands.pop_back();
+        a2 = c.param->head; // Parameter symbol
+        if (is_plain(*a2)) {
+            // Shallow binding: the old value moves to the save stack
+            bindings.push_back({ a2, a2->tail, a2->typ });
+            a2->typ  = Token::EXPR_VALUE;
+            a2->tail = a1;
+        } else {
+            bindings.push_back({ a2, eval_operand({ a2, Token::EXPR_VAR_REF }), a2->typ });
+            assign(*a2, *a1);
         }
-        if (!a1 || a1->typ != Token::EXPR_FUNCTION)
-            writes("illegal function");
-        a1 = a1->tail; // Get a_ptr (variable node) from function symbol
-        {
-            Node *op_ptr =
-                a1->head
-                    ->head; // Function body (a_ptr->head is symbol, symbol->head is function body)
-            a3base = a3  = &alloc();
-            a3->tail     = op_ptr->tail; // Save return address
-            op_ptr->tail = nullptr;
-            a1           = a1->tail;   // Parameter list
-            a2           = list->tail; // Argument list
-        f1:
-            // Match parameters to arguments
-            if (a1 != nullptr && a2 != nullptr)
-                goto f2;
-            if (a1 != a2)
-                writes("parameters do not match");
-            op_ptr = op_ptr->head;
-            goto f3;
-        f2:
-            // Bind parameter to argument value
-            a3->head = a4 = &alloc();
-            a3            = a4;
-            a3->tail      = eval_operand(*a1);      // Save old parameter value
-            assign(*a1->head, *eval(*a2->tail, 1)); // recursive
-            a1 = a1->tail;
-            a2 = a2->head;
-            goto f1;
-        f3:
-            // Execute function body
-            op_ptr = execute(*op_ptr); // recursive
-            if (op_ptr)
-                goto f3;
-            // Restore parameter values
-            // Get a_ptr: stack->head is function name, need to get back to a_ptr
-            // stack->head is TOKEN_VARIABLE node, stack->head->head is symbol (EXPR_FUNCTION)
-            // symbol->tail is a_ptr
-            a1 = stack->head;
-            if (a1->typ == Token::TOKEN_VARIABLE) {
-                a1 = a1->head; // Get symbol
-            }
-            a1 = a1->tail; // Get a_ptr
-            {
-                Node *op_ptr2 = a1->head;
-                a3            = a3base;
-                stack->head   = op_ptr2->tail; // Get return value
-                stack->typ    = Token::EXPR_VALUE;
-                op_ptr2->tail = a3->tail; // Restore return address
-            f4:
-                // Restore each parameter
-                a4 = a3->head;
-                free_node(*a3);
-                a3 = a4;
-                a1 = a1->tail;
-                if (a1 == nullptr)
-                    goto advanc;
-                assign(*a1->head, *a3->tail);
-                goto f4;
+        c.param = c.param->tail;
+        c.arg   = c.arg->head;
+    }
+    goto op_bind;
+
+op_invoke: // Execute function body on a new frame
+    {
+        PendingCall c = calls.back();
+        calls.pop_back();
+        a1   = operands[c.top].head->tail; // Function name node
+        memo = a1->ch == SnobolContext::MEMO_FUNCTION;
+        if (memo && (cached = recall(*a1, a2)) != 0) {
+            // The result is known, see recall()
+            delete_string(unbind(*a1, c.mark));
+            operands[c.top] = { a2, Token::EXPR_VALUE };
+            list            = c.call;
+            if (cached < 0) {
+                rfail = 1;
+                goto op_fail;
             }
+            EVAL_NEXT();
         }
-    case Token::TOKEN_DIV:        // Division
-    case Token::TOKEN_MULT:       // Multiplication
-    case Token::TOKEN_MINUS:      // Subtraction
-    case Token::TOKEN_PLUS:       // Addition
-    case Token::TOKEN_WHITESPACE: // Concatenation
-        // Binary operator - evaluate both operands
-        a1    = eval_operand(*stack);
-        stack = pop(stack);
-        a2    = eval_operand(*stack);
-        a3    = doop(op, *a2, *a1);
-        delete_string(a1);
-        delete_string(a2);
-        stack->head = a3;
-        stack->typ  = Token::EXPR_VALUE;
-        goto advanc;
-    case Token::TOKEN_STRING: // String literal
-        a1 = copy(list->tail);
-        {
-            stack       = &push(stack);
-            stack->head = a1;
-            stack->typ  = Token::EXPR_VALUE; // Mark as value
-            goto advanc;
+        if (tail != TAIL_NONE && calls.size() == pending) {
+            // The call is the value of f = g(x) /(return), see perform()
+            if (memo)
+                memo_calls.pop_back(); // The result belongs to the caller
+            reuse(c, tail == TAIL_RETURN);
+            operands.pop_back();
+            reused    = true;
+            suspended = true; // run() executes the body of the reused frame
+            return (nullptr);
         }
-    case Token::TOKEN_VARIABLE: // Variable reference
-        a1 = list->tail;
-        {
-            stack       = &push(stack);
-            stack->head = a1;
-            stack->typ  = Token::EXPR_VAR_REF; // Mark as variable reference
-            goto advanc;
+        if (frames.size() >= max_depth)
+            writes("call depth exceeded");
+        frames.push_back({ a1->head->head, nullptr, 0, false, nullptr, nullptr, c.call, base,
+                           pending, t, tail, c.top, a1, c.mark, nullptr, false, memo });
+    }
+    if (run_body) {
+        // A tail call reuses the frame and returns here to run its body
+        nest();
+        for (;;) {
+            run_body(*this, *frames.back().body); // recursive
+            if (!suspended)
+                break;
+            suspended = false;
+            rfail     = 0; // Of the reused statement, see reuse()
         }
-        goto advanc;
+        nesting--;
+        goto op_return;
+    }
+    if (defer) {
+        suspended = true; // run() executes the body, then resumes here
+        return (nullptr);
+    }
+    nest();
+    run(frames.back().body); // recursive
+    nesting--;
+op_return: // The function returned: its value replaces the function operand
+    {
+        Frame &f = frames.back();
+        list     = f.list;
+        top      = f.top;
+        tail     = f.tail;
+        a1       = unbind(*f.fn, f.mark);
+        if (f.recover && rfail) {
+            // A tail call failed: return the value of its caller
+            delete_string(a1);
+            a1    = f.result;
+            rfail = 0;
+        } else if (f.recover) {
+            delete_string(f.result);
+        }
+        if (f.memo)
+            remember(a1, rfail != 0);
+        operands[top] = { a1, Token::EXPR_VALUE };
+        frames.pop_back();
+    }
+    EVAL_NEXT();
+
+op_binary: // Binary operator - evaluate both operands
+    a1 = eval_operand(operands.back());
+    operands.pop_back();
+    a2 = eval_operand(operands.back());
+    a3 = doop(generic_op(list->typ), *a2, *a1);
+    delete_string(a1);
+    delete_string(a2);
+    operands.back() = { a3, Token::EXPR_VALUE };
+    if (rfail)
+        goto op_fail;
+    EVAL_NEXT();
+
+op_integer: // Arithmetic on operands inferred to be integers, see infer()
+    top = operands.size() - 1;
+    if (rfail || !int_operand(operands[top - 1], n1) || !int_operand(operands[top], n2) ||
+        !arith(generic_op(list->typ), n1, n2, n))
+        goto op_binary; // Reports errors, or computes with bignums
+    if (operands[top].typ == Token::EXPR_VALUE)
+        delete_string(operands[top].head);
+    operands.pop_back();
+    if (operands.back().typ == Token::EXPR_VALUE)
+        delete_string(operands.back().head);
+    operands.back() = { &integer(n), Token::EXPR_VALUE };
+    EVAL_NEXT();
+
+op_concat: // Concatenation with an integer operand, see infer()
+    if (rfail)
+        goto op_binary;
+    a1 = text_operand(operands.back());
+    operands.pop_back();
+    a2 = text_operand(operands.back());
+    if (a2 == nullptr) {
+        a2 = a1;
+    } else if (a1 != nullptr) {
+        // Both strings are new, so join them without copying
+        a2->tail->head = a1->head;
+        a2->tail       = a1->tail;
+        free_node(*a1);
+    }
+    operands.back() = { a2, Token::EXPR_VALUE };
+    EVAL_NEXT();
+
+op_fail: // Failure ends the expression, and with it the statement
+    while (calls.size() > pending) {
+        // Undo the calls whose arguments were being evaluated
+        a1 = operands[calls.back().top].head->tail;
+        delete_string(unbind(*a1, calls.back().mark));
+        calls.pop_back();
     }
-    return nullptr;
+    while (operands.size() > base) {
+        if (operands.back().typ == Token::EXPR_VALUE)
+            delete_string(operands.back().head);
+        operands.pop_back();
+    }
+    return (nullptr);
+
+op_string: // String literal
+    operands.push_back({ copy(list->tail), Token::EXPR_VALUE }); // Mark as value
+    EVAL_NEXT();
+
+op_var: // Variable reference
+    operands.push_back({ list->tail, Token::EXPR_VAR_REF }); // Mark as variable reference
+    EVAL_NEXT();
 }
 
 //
 // Execute a binary operator on two string operands.
-// Converts strings to numbers for arithmetic operations.
+// Converts strings to numbers for arithmetic operations,
+// which return integer values, see integer().
+// Arithmetic that overflows 64 bits fails the statement, unless bignums
+// are enabled (see bigop()); so does division by zero. A failure left
+// by an operand, such as syspit at the end of input, is kept.
 //
 Node *SnobolContext::doop(Token op, const Node &arg1, const Node &arg2)
 {
+    int64_t result;
+    int fail = rfail;
+
     switch (op) {
-    case Token::TOKEN_DIV: // Division
-        return &divide(arg1, arg2);
-    case Token::TOKEN_MULT: // Multiplication
-        return &mult(arg1, arg2);
-    case Token::TOKEN_PLUS: // Addition
-        return &add(arg1, arg2);
+    case Token::TOKEN_DIV:   // Division
+    case Token::TOKEN_MULT:  // Multiplication
+    case Token::TOKEN_PLUS:  // Addition
     case Token::TOKEN_MINUS: // Subtraction
-        return &sub(arg1, arg2);
+        if (arith(op, strbin(&arg1), strbin(&arg2), result) && !rfail)
+            return &integer(result);
+        if (bignums && fail == 0) {
+            rfail = 0;
+            return bigop(op, arg1, arg2);
+        }
+        rfail = 1; // Overflow or division by zero
+        return &integer(0);
     case Token::TOKEN_WHITESPACE: // Concatenation
         return (cat(&arg1, &arg2));
     default:
@@ -207,125 +593,541 @@ Node *SnobolContext::doop(Token op, const Node &arg1, const Node &arg2)
     }
 }
 
+//
+// Find the goto structure of a compiled statement.
+// Fused statements keep the layout of the statement they replace.
+//
+static const Node &goto_part(const Node &e)
+{
+    const Node *r = e.tail;
+
+    switch (e.typ) {
+    case Token::STMT_SIMPLE: // r g
+        return *r->head;
+    case Token::STMT_REPLACE: // r m a g
+    case Token::STMT_GLOBAL:
+        return *r->head->head->head;
+    default: // r m g, r a g
+        return *r->head->head;
+    }
+}
+
+//
+// Undo the bindings of a call to the function with name node fn:
+// restore the values saved on the binding stack above mark, its own
+// return value among them. Parameters are restored even when the
+// call failed. Returns the value the function returned.
+//
+Node *SnobolContext::unbind(Node &fn, size_t mark)
+{
+    Node *holder = fn.head; // Definition: tail is the return value
+    Node *value;
+    int fail = rfail;
+
+    value        = holder->tail;
+    holder->tail = nullptr;
+    rfail        = 0;
+    while (bindings.size() > mark) {
+        Binding &b = bindings.back();
+        if (b.typ == Token::EXPR_VAR_REF || b.typ == Token::EXPR_VALUE) {
+            // Put back the value moved aside by op_arg
+            if (b.sym->typ == Token::EXPR_VALUE)
+                delete_string(b.sym->tail);
+            b.sym->typ  = b.typ;
+            b.sym->tail = b.value;
+        } else {
+            assign(*b.sym, *b.value);
+        }
+        bindings.pop_back();
+    }
+    rfail = fail;
+    return (value);
+}
+
+//
+// Run the call c in tail position on the frame of the running function,
+// instead of a new frame. The bindings of the call stay on the frame,
+// except for symbols the frame already saved: the values they held
+// belong to the running function, which has nothing left to do, so
+// recursion in tail position runs in constant space. With recover, a
+// failure of the call returns the running function's value instead,
+// as the /(return) of the failed statement would.
+//
+void SnobolContext::reuse(const PendingCall &c, bool recover)
+{
+    Frame &f = frames.back();
+    Node *fn = operands[c.top].head->tail; // Function name node
+    Node *value;
+    size_t i, j, k;
+
+    // Take the value of the running function
+    if (fn == f.fn) {
+        value                  = bindings[c.mark].value;
+        bindings[c.mark].value = nullptr;
+    } else {
+        value            = f.fn->head->tail;
+        f.fn->head->tail = nullptr;
+    }
+    if (recover) {
+        if (f.recover)
+            delete_string(f.result);
+        f.result  = value;
+        f.recover = true;
+    } else {
+        delete_string(value);
+    }
+
+    // Drop the bindings of symbols the frame restores anyway
+    for (i = j = c.mark; i < bindings.size(); i++) {
+        for (k = f.mark; k < c.mark && bindings[k].sym != bindings[i].sym; k++)
+            ;
+        if (k < c.mark)
+            delete_string(bindings[i].value);
+        else
+            bindings[j++] = bindings[i];
+    }
+    bindings.resize(j);
+    f.fn   = fn;
+    f.body = fn->head->head;
+}
+
+//
+// Get how much of the C++ stack calls that nest on it may use:
+// three quarters of its size limit, leaving room for the rest.
+//
+static size_t stack_limit()
+{
+    static size_t limit = 0;
+    size_t size         = 1 << 20; // Smallest common default
+
+    if (limit != 0)
+        return limit;
+#if __has_include(<sys/resource.h>)
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_STACK, &rl) == 0)
+        size = rl.rlim_cur == RLIM_INFINITY ? size_t{ 1 } << 30 : rl.rlim_cur;
+#endif
+    limit = size / 4 * 3;
+    return limit;
+}
+
+//
+// Count a call whose body runs on the C++ stack: one made while matching
+// a pattern or by replace_all(), or any call of a translated program.
+// These cannot be left on a frame for run() to pick up, so they stop with
+// the call depth error when the stack is about to run out.
+//
+void SnobolContext::nest()
+{
+    char here;
+    uintptr_t sp = reinterpret_cast<uintptr_t>(&here);
+
+    if (nesting++ == 0) {
+        stack_base = sp;
+        return;
+    }
+    if ((stack_base > sp ? stack_base - sp : sp - stack_base) > stack_limit())
+        writes("call depth exceeded");
+}
+
 //
 // Execute a compiled statement.
 // Handles simple statements, pattern matching, assignments, and goto operations.
+// Function calls made by the statement nest, see run().
 // Returns the next statement to execute, or NULL to stop.
 //
 Node *SnobolContext::execute(const Node &e)
+{
+    if (e.typ < Token::STMT_SIMPLE || e.typ > Token::STMT_GLOBAL) {
+        lc = e.ch;
+        writes("invalid statement type");
+        return nullptr;
+    }
+    return jump(e, perform(e));
+}
+
+//
+// Execute statements from c until control leaves the level it started
+// at: the end of the program, or the return of the function being run.
+// A statement that calls a function is left on the function's frame,
+// and the body runs in this same loop; when it returns, the statement
+// continues where it stopped. So the depth of Snobol calls is limited
+// by max_depth, not by the C++ stack. Calls made while matching a
+// pattern or by replace_all() still nest, see nest().
+//
+void SnobolContext::run(const Node *c)
+{
+    size_t level = frames.size();
+    const Node *next;
+    bool success;
+
+    for (;;) {
+        if (c == nullptr) {
+            if (frames.size() == level)
+                return;
+            // A function returned, continue the statement that called it
+            c        = frames.back().stmt;
+            resuming = true;
+            if (frames.back().step == STEP_GOTO) {
+                success = frames.back().success;
+                goto go;
+            }
+        }
+        suspend_calls = true;
+        success       = perform(*c);
+        if (suspended)
+            goto call;
+    go:
+        suspend_calls = true;
+        next          = jump(*c, success);
+        if (suspended)
+            goto call;
+        c = next;
+        continue;
+    call:
+        suspended = false;
+        c         = frames.back().body;
+    }
+}
+
+//
+// Perform the action of a compiled statement, without the goto.
+// When suspend_calls is set, a function call leaves the statement on the
+// function's frame with suspended set; run() calls perform() again with
+// resuming set when the function returns, and the statement continues
+// at the expression that made the call.
+// Returns true on success, false on failure.
+//
+bool SnobolContext::perform(const Node &e)
 {
     Node *r, *b, *c;
-    Node *m, *ca, *d, *a;
+    Node *m, *ca, *d;
+    int64_t n;
+    int step;
+    bool defer;
+
+#if SNO_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+    // Indexed by statement type, starting from STMT_SIMPLE
+    static void *const targets[] = {
+        &&stmt_simple,  // STMT_SIMPLE
+        &&stmt_match,   // STMT_MATCH
+        &&stmt_assign,  // STMT_ASSIGN
+        &&stmt_replace, // STMT_REPLACE
+        &&stmt_read,    // STMT_READ
+        &&stmt_write,   // STMT_WRITE
+        &&stmt_incr,    // STMT_INCR
+        &&stmt_find,    // STMT_FIND
+        &&stmt_tail,    // STMT_TAIL
+        &&stmt_global,  // STMT_GLOBAL
+    };
+#pragma GCC diagnostic pop
+#endif
 
     r  = e.tail; // Statement data
     lc = e.ch;   // Line number
+    if (time_limit > 0 && (++ticks & 1023) == 0)
+        check_deadline();
+    if (matching == 0)
+        statement_steps = 0; // Not run by a match of another statement, see spend()
+    b             = nullptr;
+    d             = nullptr;
+    defer         = suspend_calls;
+    suspend_calls = false;
+    if (resuming) {
+        // Continue at the expression that made the call
+        b = frames.back().value;
+        d = frames.back().match;
+        switch (frames.back().step) {
+        case STEP_SIMPLE:
+            goto stmt_simple;
+        case STEP_MATCH:
+            goto stmt_match;
+        case STEP_ASSIGN_TARGET:
+            goto stmt_assign;
+        case STEP_ASSIGN_VALUE:
+            ca = r->head;
+            goto assign_value;
+        case STEP_REPLACE_TARGET:
+            goto stmt_replace;
+        case STEP_REPLACE_VALUE:
+            m  = r->head;
+            ca = m->head;
+            goto replace_value;
+        default:
+            goto stmt_invalid;
+        }
+    }
+#if SNO_COMPUTED_GOTO
+    if (stmt_slot(e.typ) < std::size(targets))
+        COMPUTED_GOTO(targets[stmt_slot(e.typ)]);
+    goto stmt_invalid;
+#else
     switch (e.typ) {
-    case Token::STMT_SIMPLE: // r g - Simple statement: evaluate expression and goto
-        a = r->head;
-        delete_string(eval(*r->tail, 1));
-        goto xsuc;
-    case Token::STMT_MATCH:    // r m g - Pattern matching: match pattern against subject
-        m = r->head;           // Match pattern
-        a = m->head;           // Goto structure
-        b = eval(*r->tail, 1); // Evaluate subject
-        c = search(*m, b);     // Search for pattern
-        delete_string(b);
-        if (c == nullptr)
+    case Token::STMT_SIMPLE:
+        goto stmt_simple;
+    case Token::STMT_MATCH:
+        goto stmt_match;
+    case Token::STMT_ASSIGN:
+        goto stmt_assign;
+    case Token::STMT_REPLACE:
+        goto stmt_replace;
+    case Token::STMT_READ:
+        goto stmt_read;
+    case Token::STMT_WRITE:
+        goto stmt_write;
+    case Token::STMT_INCR:
+        goto stmt_incr;
+    case Token::STMT_FIND:
+        goto stmt_find;
+    case Token::STMT_TAIL:
+        goto stmt_tail;
+    case Token::STMT_GLOBAL:
+        goto stmt_global;
+    default:
+        goto stmt_invalid;
+    }
+#endif
+
+stmt_simple: // r g - Simple statement: evaluate expression and goto
+    suspend_calls = defer;
+    b             = eval(*r->tail, 1);
+    step          = STEP_SIMPLE;
+    if (suspended)
+        goto suspend;
+    delete_string(b);
+    goto xsuc;
+stmt_match: // r m g - Pattern matching: match pattern against subject
+    m             = r->head; // Match pattern
+    suspend_calls = defer;
+    b             = eval(*r->tail, 1); // Evaluate subject
+    step          = STEP_MATCH;
+    if (suspended)
+        goto suspend;
+    c = search(*m, text(b)); // Search for pattern
+    delete_string(b);
+    if (c == nullptr)
+        goto xfail;
+    free_node(*c);
+    goto xsuc;
+stmt_assign: // r a g - Assignment: assign value to variable
+    ca            = r->head; // Assignment structure
+    suspend_calls = defer;
+    b             = eval(*r->tail, 0); // Get variable reference
+    step          = STEP_ASSIGN_TARGET;
+    if (suspended)
+        goto suspend;
+assign_value:
+    suspend_calls = defer;
+    c             = eval(*ca->tail, 1);
+    step          = STEP_ASSIGN_VALUE;
+    if (suspended)
+        goto suspend;
+    assign(*b, *c); // Assign value
+    goto xsuc;
+stmt_replace: // r m a g - Pattern replacement
+    // search() returns: d->head = char before match (nullptr if at start), d->tail = char after
+    // match (nullptr if at end)
+    {
+        Node *before_node, *after_node, *result_node;
+        m             = r->head; // Match pattern
+        ca            = m->head; // Assignment structure
+        suspend_calls = defer;
+        b             = eval(*r->tail, 0); // Get variable reference
+        step          = STEP_REPLACE_TARGET;
+        if (suspended)
+            goto suspend;
+        if (b == nullptr)
             goto xfail;
-        free_node(*c);
-        goto xsuc;
-    case Token::STMT_ASSIGN:             // r a g - Assignment: assign value to variable
-        ca = r->head;                    // Assignment structure
-        a  = ca->head;                   // Goto structure
-        b  = eval(*r->tail, 0);          // Get variable reference
-        assign(*b, *eval(*ca->tail, 1)); // Assign value
-        goto xsuc;
-    case Token::STMT_REPLACE: // r m a g - Pattern replacement
-        // search() returns: d->head = char before match (nullptr if at start), d->tail = char after
-        // match (r->tail if at end)
-        {
-            Node *before_node, *after_node, *result_node;
-            m  = r->head;             // Match pattern
-            ca = m->head;             // Assignment structure
-            a  = ca->head;            // Goto structure
-            b  = eval(*r->tail, 0);   // Get variable reference
-            d  = search(*m, b->tail); // Search pattern in variable's value
-            if (d == nullptr)
-                goto xfail;
-            c = eval(*ca->tail, 1); // Evaluate replacement value
-            // Check if match spans entire string
-            if (d->head == nullptr && d->tail == b->tail->tail) {
-                // Match entire string - replace
-                assign(*b, *c);
-                free_node(*d);
-                delete_string(c);
-                goto xsuc;
-            }
-            // Check if match at end
-            if (d->tail == b->tail->tail) {
-                // Match at end - replace: [before] + [replacement]
-                before_node       = &alloc();
-                before_node->head = b->tail->head; // First character
-                before_node->tail = d->head;       // Last character before match
-                result_node       = cat(before_node, c);
-                free_node(*before_node);
-                assign(*b, *result_node);
-                free_node(*d);
-                delete_string(c);
-                goto xsuc;
-            }
-            // Check if match at start
-            if (d->head == nullptr) {
-                // Match at start - replace: [replacement] + [after]
-                after_node       = &alloc();
-                after_node->head = d->tail;       // First character after match
-                after_node->tail = b->tail->tail; // End marker
-                result_node      = cat(c, after_node);
-                free_node(*after_node);
-                assign(*b, *result_node);
-                free_node(*d);
-                delete_string(c);
-                goto xsuc;
-            }
-            // Match in middle - replace: [before] + [replacement] + [after]
+        d = search(*m, text(b->tail)); // Search pattern in variable's value
+        if (d == nullptr)
+            goto xfail;
+    replace_value:
+        suspend_calls = defer;
+        c             = eval(*ca->tail, 1); // Evaluate replacement value
+        step          = STEP_REPLACE_VALUE;
+        if (suspended)
+            goto suspend;
+        // Keep the parts of the subject before and after the match
+        result_node = c;
+        if (d->head != nullptr) {
             before_node       = &alloc();
             before_node->head = b->tail->head; // First character
             before_node->tail = d->head;       // Last character before match
-            after_node        = &alloc();
-            after_node->head  = d->tail;       // First character after match
-            after_node->tail  = b->tail->tail; // End marker
             result_node       = cat(before_node, c);
             free_node(*before_node);
-            result_node = cat(result_node, after_node);
+            delete_string(c);
+        }
+        if (d->tail != nullptr) {
+            after_node       = &alloc();
+            after_node->head = d->tail;       // First character after match
+            after_node->tail = b->tail->tail; // Last character
+            c                = result_node;
+            result_node      = cat(c, after_node);
             free_node(*after_node);
-            assign(*b, *result_node);
-            free_node(*d);
             delete_string(c);
+        }
+        free_node(*d);
+        assign(*b, *result_node);
+        goto xsuc;
+    }
+stmt_global: // r m a g - Replace every match, see replace_all()
+    // Calls nest, as they do while matching
+    m  = r->head; // Match pattern
+    ca = m->head; // Assignment structure
+    b  = eval(*r->tail, 0);
+    if (b == nullptr)
+        goto xfail;
+    if (!replace_all(*m, *ca->tail, copy(text(b->tail)), c))
+        goto xfail;
+    assign(*b, *c);
+    goto xsuc;
+
+//
+// Fused statements, see fuse(). Each checks that the variables involved
+// hold plain values and otherwise takes the generic path.
+//
+stmt_read: // x = syspit
+    b = r->tail->tail; // Target variable
+    if (!is_plain(*b))
+        goto stmt_assign;
+    flush();
+    c = syspit();
+    if (rfail)
+        goto xfail;
+    b->typ = Token::EXPR_VALUE;
+    delete_string(b->tail);
+    b->tail = c;
+    goto xsuc;
+stmt_write: // syspot = x, syspot = "lit"
+    ca = r->head; // Assignment structure
+    b  = ca->tail;
+    if (r->tail->tail->typ != Token::EXPR_SYSPOT)
+        goto stmt_assign;
+    if (b->typ == Token::TOKEN_VARIABLE) {
+        b = b->tail; // Source variable
+        if (!is_plain(*b))
+            goto stmt_assign;
+        b->typ = Token::EXPR_VALUE;
+        if (is_binary(*b)) {
+            sysput(&binstr(strbin(b->tail)));
             goto xsuc;
         }
+    }
+    syspot(text(b->tail));
+    goto xsuc;
+stmt_incr: // n = n + "k", n = n - "k"
+    ca = r->head;       // Assignment structure
+    b  = r->tail->tail; // Variable
+    if (!is_plain(*b))
+        goto stmt_assign;
+    c = ca->tail->head;       // Literal
+    d = ca->tail->head->head; // Operator
+    if (!arith(generic_op(d->typ), strbin(b->tail), strbin(c->tail), n) || rfail) {
+        if (bignums) {
+            rfail = 0;
+            goto stmt_assign;
+        }
+        goto xfail;
+    }
+    m      = &integer(n);
+    b->typ = Token::EXPR_VALUE;
+    delete_string(b->tail);
+    b->tail = m;
+    goto xsuc;
+stmt_find: // x "lit"
+    b = r->tail->tail; // Subject variable
+    if (!is_plain(*b))
+        goto stmt_match;
+    m      = r->head; // Match pattern
+    b->typ = Token::EXPR_VALUE;
+    if (is_binary(*b)) {
+        c = &binstr(strbin(b->tail));
+        n = contains(c, m->tail->tail->tail);
+        delete_string(c);
+        if (!n)
+            goto xfail;
+        goto xsuc;
+    }
+    if (!contains(text(b->tail), m->tail->tail->tail))
+        goto xfail;
+    goto xsuc;
 
-    default:
-        // Invalid statement type
-        writes("invalid statement type");
-        return nullptr;
+stmt_tail: // f = g(x) /(return)
+    b = r->tail->tail; // Target variable
+    if ((!defer && run_body == nullptr) || frames.empty() || b->typ != Token::EXPR_FUNCTION ||
+        b->tail != frames.back().fn)
+        goto stmt_assign; // Not the value of the running function
+    ca            = r->head;
+    suspend_calls = defer;
+    tail_call     = goto_part(e).tail->tail == lookret ? TAIL_RETURN : TAIL_FRETURN;
+    c             = eval(*ca->tail, 1);
+    step          = STEP_ASSIGN_VALUE;
+    if (suspended)
+        goto suspend;
+    assign(*b, *c);
+    goto xsuc;
+
+suspend: // Left at a call, run() continues here when it returns
+    if (reused) {
+        // The call runs on the frame of this function, see reuse()
+        reused = false;
+        return false;
     }
+    frames.back().stmt  = &e;
+    frames.back().step  = step;
+    frames.back().value = b;
+    frames.back().match = d;
+    return false;
+stmt_invalid:
+    writes("invalid statement type");
+    return false;
 xsuc:
-    // Success path - check for goto
     if (rfail)
         goto xfail;
-    b = a->head; // Success goto
-    goto xboth;
+    return true;
 xfail:
-    // Failure path - check for goto
     rfail = 0;
-    b     = a->tail; // Failure goto
-xboth:
+    return false;
+}
+
+//
+// Stop the program when the time limit has passed, see start_clock().
+//
+void SnobolContext::check_deadline()
+{
+    if (std::chrono::steady_clock::now() >= deadline)
+        writes("time limit exceeded");
+}
+
+//
+// Follow the success or failure goto of a statement.
+// Returns the next statement to execute, or NULL to stop.
+//
+Node *SnobolContext::jump(const Node &e, bool success)
+{
+    const Node &g = goto_part(e);
+    Node *b;
+    bool defer;
+
+    defer         = suspend_calls;
+    suspend_calls = false;
+    b             = success ? g.head : g.tail;
     if (b == nullptr) {
         // No goto - continue to next statement
         return (e.head);
     }
     // Evaluate goto target
-    b = eval(*b, 0);
+    suspend_calls = defer;
+    b             = eval(*b, 0);
+    if (suspended) {
+        // Left at a call, see run()
+        frames.back().stmt    = &e;
+        frames.back().step    = STEP_GOTO;
+        frames.back().success = success;
+        return (nullptr);
+    }
     if (b == lookret) // Return statement
         return (nullptr);
     if (b == lookfret) { // Failure return
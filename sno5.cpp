@@ -0,0 +1,232 @@
+//
+// Precompiled program images.
+//
+// An image is a copy of the whole node pool right after compilation,
+// with every pointer replaced by a node index, so it can be loaded
+// at any address. Index 0 stands for a null pointer, index i+1 for
+// node i of the pool. Records use native byte order and are only
+// meant to be loaded by the same build of the interpreter.
+//
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "sno.h"
+
+namespace {
+
+const char IMAGE_MAGIC[4]      = { 'S', 'N', 'O', 'C' };
+const uint32_t IMAGE_VERSION   = 5;
+const uint32_t IMAGE_BYTEORDER = 0x01020304;
+
+//
+// Context pointers saved in the image header.
+//
+enum ImageRoot {
+    ROOT_NAMELIST,
+    ROOT_PROGRAM,
+    ROOT_FREELIST,
+    ROOT_LOOKF,
+    ROOT_LOOKS,
+    ROOT_LOOKEND,
+    ROOT_LOOKSTART,
+    ROOT_LOOKDEF,
+    ROOT_LOOKRET,
+    ROOT_LOOKFRET,
+    ROOT_LOOKMEMO,
+    ROOT_COUNT
+};
+
+struct ImageHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteorder;
+    uint32_t count; // Number of node records
+    uint32_t roots[ROOT_COUNT];
+};
+
+struct ImageNode {
+    uint32_t head;
+    uint32_t tail;
+    int32_t typ;
+    int32_t ch;
+};
+
+//
+// Translate node pointers to image indices.
+// Pool blocks are sorted by address so a pointer is found by binary search.
+//
+class NodeIndex {
+public:
+    explicit NodeIndex(const SnobolContext &ctx)
+    {
+        for (size_t i = 0; i < ctx.mem_pool.size(); i++)
+            blocks.emplace_back(ctx.mem_pool[i]->data(), i);
+        std::sort(blocks.begin(), blocks.end());
+    }
+
+    // Pointers outside the pool can only be stale fields of free nodes,
+    // so they are stored as null.
+    uint32_t operator()(const Node *p) const
+    {
+        if (p == nullptr)
+            return 0;
+        auto it = std::upper_bound(blocks.begin(), blocks.end(),
+                                   std::make_pair(p, ~static_cast<size_t>(0)));
+        if (it == blocks.begin())
+            return 0;
+        --it;
+        if (p >= it->first + SnobolContext::BLOCK_SIZE)
+            return 0;
+        return static_cast<uint32_t>(it->second * SnobolContext::BLOCK_SIZE + (p - it->first) + 1);
+    }
+
+private:
+    std::vector<std::pair<const Node *, size_t>> blocks;
+};
+
+} // namespace
+
+//
+// Write the compiled program and symbol table as an image.
+// Must be called after compile_program() and before execution.
+//
+void SnobolContext::save_image(std::ostream &out) const
+{
+    NodeIndex index(*this);
+    ImageHeader header{};
+
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.version                 = IMAGE_VERSION;
+    header.byteorder               = IMAGE_BYTEORDER;
+    header.count                   = static_cast<uint32_t>(mem_pool.size() * BLOCK_SIZE);
+    header.roots[ROOT_NAMELIST]    = index(namelist);
+    header.roots[ROOT_PROGRAM]     = index(program);
+    header.roots[ROOT_FREELIST]    = index(freelist);
+    header.roots[ROOT_LOOKF]       = index(lookf);
+    header.roots[ROOT_LOOKS]       = index(looks);
+    header.roots[ROOT_LOOKEND]     = index(lookend);
+    header.roots[ROOT_LOOKSTART]   = index(lookstart);
+    header.roots[ROOT_LOOKDEF]     = index(lookdef);
+    header.roots[ROOT_LOOKRET]     = index(lookret);
+    header.roots[ROOT_LOOKFRET]    = index(lookfret);
+    header.roots[ROOT_LOOKMEMO]    = index(lookmemo);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (auto &block : mem_pool) {
+        for (auto &node : *block) {
+            ImageNode rec;
+            rec.head = index(node.head);
+            rec.tail = index(node.tail);
+            rec.typ  = static_cast<int32_t>(node.typ);
+            rec.ch   = node.ch;
+            out.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+        }
+    }
+}
+
+//
+// Check whether a file starts with the image signature.
+//
+bool SnobolContext::is_image(const char *path)
+{
+    char magic[sizeof(IMAGE_MAGIC)];
+    std::ifstream file(path, std::ios::binary);
+
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, IMAGE_MAGIC, sizeof(magic)) == 0;
+}
+
+//
+// Replace the node pool and symbol table with a program image file.
+// The file is mapped into memory and loaded from there.
+// Returns false if the file cannot be read or is not a valid image.
+//
+bool SnobolContext::load_image(const char *path)
+{
+    struct stat st;
+    int fd;
+    void *map;
+    bool ok;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(ImageHeader)) {
+        close(fd);
+        return false;
+    }
+    map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    ok = load_image(map, st.st_size);
+    munmap(map, st.st_size);
+    return ok;
+}
+
+//
+// Replace the node pool and symbol table with a program image in memory,
+// relocating each record into a fresh pool.
+// Returns false if the data is not a valid image.
+//
+bool SnobolContext::load_image(const void *data, size_t size)
+{
+    if (size < sizeof(ImageHeader))
+        return false;
+
+    auto *header = static_cast<const ImageHeader *>(data);
+    auto *rec    = reinterpret_cast<const ImageNode *>(header + 1);
+    if (std::memcmp(header->magic, IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != IMAGE_VERSION || header->byteorder != IMAGE_BYTEORDER ||
+        header->count % BLOCK_SIZE != 0 ||
+        size != sizeof(ImageHeader) + static_cast<size_t>(header->count) * sizeof(ImageNode))
+        return false;
+
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (rec[i].head > header->count || rec[i].tail > header->count)
+            return false;
+    }
+    for (uint32_t root : header->roots) {
+        if (root > header->count)
+            return false;
+    }
+
+    // Allocate the new pool, then relocate records into it
+    mem_pool.clear();
+    patterns.clear();
+    for (uint32_t i = 0; i < header->count; i += BLOCK_SIZE)
+        mem_pool.push_back(std::make_unique<NodeBlock>());
+    auto node = [this](uint32_t index) -> Node * {
+        if (index == 0)
+            return nullptr;
+        index--;
+        return &(*mem_pool[index / BLOCK_SIZE])[index % BLOCK_SIZE];
+    };
+    for (uint32_t i = 0; i < header->count; i++) {
+        Node &n = *node(i + 1);
+        n.head  = node(rec[i].head);
+        n.tail  = node(rec[i].tail);
+        n.typ   = static_cast<Token>(rec[i].typ);
+        n.ch    = static_cast<char>(rec[i].ch);
+    }
+    namelist  = node(header->roots[ROOT_NAMELIST]);
+    program   = node(header->roots[ROOT_PROGRAM]);
+    freelist  = node(header->roots[ROOT_FREELIST]);
+    lookf     = node(header->roots[ROOT_LOOKF]);
+    looks     = node(header->roots[ROOT_LOOKS]);
+    lookend   = node(header->roots[ROOT_LOOKEND]);
+    lookstart = node(header->roots[ROOT_LOOKSTART]);
+    lookdef   = node(header->roots[ROOT_LOOKDEF]);
+    lookret   = node(header->roots[ROOT_LOOKRET]);
+    lookfret  = node(header->roots[ROOT_LOOKFRET]);
+    lookmemo  = node(header->roots[ROOT_LOOKMEMO]);
+    cfail     = 1; // Same state as after compile_program()
+    return true;
+}
@@ -0,0 +1,448 @@
+//
+// Ahead-of-time translation to C++.
+//
+// The compiled program is written out as a C++ translation unit which
+// embeds the program image and links against the snobol library.
+// Every statement becomes a label, gotos to fixed labels become C++
+// gotos, and each entry point (the program and each function) becomes
+// a C++ function holding the statements reachable from it.
+// Statement actions, patterns and I/O still run in the library through
+// perform(); only goto targets computed at run time go through jump().
+//
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "sno.h"
+
+namespace {
+
+//
+// Where control goes after a statement succeeds or fails.
+//
+enum class Action {
+    NEXT,    // Fall through to the next statement (or stop after the last)
+    LABEL,   // Transfer to a label known at compile time
+    RETURN,  // Return from function
+    FRETURN, // Fail return from function
+    DYNAMIC, // Target computed at run time
+};
+
+struct Transfer {
+    Action action;
+    size_t target; // Statement index for Action::LABEL
+};
+
+//
+// An entry point translated into one C++ function.
+//
+struct Unit {
+    std::string name;         // C++ function name
+    std::string comment;      // What it was translated from
+    size_t entry;             // Index of the first statement
+    std::set<size_t> stmts;   // Statements reachable from the entry
+    std::set<size_t> targets; // Statements that need a label
+    bool dynamic{};           // Has a goto computed at run time
+};
+
+class Translator {
+public:
+    Translator(const SnobolContext &ctx, std::ostream &out) : ctx(ctx), out(out) {}
+    void run();
+
+private:
+    const SnobolContext &ctx;
+    std::ostream &out;
+    std::vector<const Node *> stmts;     // Statements in program order
+    std::map<const Node *, size_t> num;  // Statement to index
+    std::vector<size_t> labeled;         // Indices of labeled statements
+    std::map<size_t, std::string> names; // Label names of statements
+    std::vector<Unit> units;
+
+    Transfer transfer(const Node *target) const;
+    Transfer transfer(size_t i, bool success) const;
+    void reach(Unit &unit) const;
+    size_t follow(const Unit &unit, size_t i) const;
+    size_t target(const Transfer &t, size_t i) const;
+    void label(Unit &unit) const;
+    bool same(size_t i) const;
+    std::vector<std::string> action(const Transfer &t, size_t i, bool success, size_t next) const;
+    void emit_lines(const std::vector<std::string> &lines, const char *indent) const;
+    void emit_if(const char *cond, size_t i, const std::vector<std::string> &lines) const;
+    void emit_unit(const Unit &unit) const;
+    void emit_image() const;
+    void emit_main() const;
+};
+
+//
+// Get the goto expression list of a statement, or null when there is none.
+//
+const Node *goto_expr(const Node &e, bool success)
+{
+    const Node *g = e.tail->head;
+
+    if (e.typ == Token::STMT_REPLACE || e.typ == Token::STMT_GLOBAL) // r m a g
+        g = g->head->head;
+    else if (e.typ != Token::STMT_SIMPLE) // r m g, r a g
+        g = g->head;
+    return success ? g->head : g->tail;
+}
+
+//
+// Get the characters of a symbol name.
+//
+std::string name_of(const Node &sym)
+{
+    std::string name;
+    const Node *s = sym.head;
+
+    if (s == nullptr)
+        return name;
+    for (const Node *c = s; c != s->tail;) {
+        c = c->head;
+        name += c->ch;
+    }
+    return name;
+}
+
+//
+// Make a C++ identifier from a prefix, a number and a Snobol name.
+//
+std::string identifier(const char *prefix, size_t n, const std::string &name)
+{
+    std::string id = prefix + std::to_string(n) + "_";
+
+    for (char c : name)
+        id += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    return id;
+}
+
+//
+// Classify a goto target expression.
+//
+Transfer Translator::transfer(const Node *target) const
+{
+    if (target->typ != Token::TOKEN_VARIABLE || target->head->typ != Token::TOKEN_END)
+        return { Action::DYNAMIC, 0 };
+
+    const Node *sym = target->tail;
+    if (sym == ctx.lookret)
+        return { Action::RETURN, 0 };
+    if (sym == ctx.lookfret)
+        return { Action::FRETURN, 0 };
+    if (sym->typ == Token::EXPR_LABEL && num.count(sym->tail))
+        return { Action::LABEL, num.at(sym->tail) };
+    return { Action::DYNAMIC, 0 };
+}
+
+Transfer Translator::transfer(size_t i, bool success) const
+{
+    const Node *target = goto_expr(*stmts[i], success);
+
+    if (target == nullptr)
+        return { Action::NEXT, 0 };
+    return transfer(target);
+}
+
+//
+// Collect the statements reachable from the entry of a unit.
+//
+void Translator::reach(Unit &unit) const
+{
+    std::vector<size_t> work{ unit.entry };
+
+    while (!work.empty()) {
+        size_t i = work.back();
+        work.pop_back();
+        if (!unit.stmts.insert(i).second)
+            continue;
+        for (bool success : { true, false }) {
+            Transfer t = transfer(i, success);
+            switch (t.action) {
+            case Action::NEXT:
+                if (i + 1 < stmts.size())
+                    work.push_back(i + 1);
+                break;
+            case Action::LABEL:
+                work.push_back(t.target);
+                break;
+            case Action::DYNAMIC:
+                if (!unit.dynamic) {
+                    unit.dynamic = true;
+                    work.insert(work.end(), labeled.begin(), labeled.end());
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+//
+// Get the statement emitted after statement i in a unit,
+// or the statement count after the last one.
+//
+size_t Translator::follow(const Unit &unit, size_t i) const
+{
+    auto it = unit.stmts.upper_bound(i);
+
+    return it == unit.stmts.end() ? stmts.size() : *it;
+}
+
+//
+// Get the statement a transfer jumps to within the unit,
+// or the statement count if it leaves the unit or is computed at run time.
+//
+size_t Translator::target(const Transfer &t, size_t i) const
+{
+    if (t.action == Action::LABEL)
+        return t.target;
+    if (t.action == Action::NEXT && i + 1 < stmts.size())
+        return i + 1;
+    return stmts.size();
+}
+
+//
+// Find the statements of a unit which need a label.
+//
+void Translator::label(Unit &unit) const
+{
+    if (unit.entry != *unit.stmts.begin())
+        unit.targets.insert(unit.entry);
+    if (unit.dynamic)
+        unit.targets.insert(labeled.begin(), labeled.end());
+    for (size_t i : unit.stmts) {
+        size_t s = target(transfer(i, true), i);
+        size_t f = target(transfer(i, false), i);
+        if (s < stmts.size() && (s != follow(unit, i) || (!same(i) && f == follow(unit, i))))
+            unit.targets.insert(s);
+        if (f < stmts.size() && !same(i) && f != follow(unit, i))
+            unit.targets.insert(f);
+    }
+}
+
+//
+// Check whether statement i goes to the same place on success and failure.
+//
+bool Translator::same(size_t i) const
+{
+    Transfer s = transfer(i, true);
+    Transfer f = transfer(i, false);
+
+    if (s.action == Action::DYNAMIC || f.action == Action::DYNAMIC)
+        return goto_expr(*stmts[i], true) == goto_expr(*stmts[i], false); // /($x)
+    return action(s, i, true, stmts.size()) == action(f, i, false, stmts.size());
+}
+
+//
+// Get the C++ lines for a transfer of control after statement i,
+// leaving out a jump to the statement emitted next.
+//
+std::vector<std::string> Translator::action(const Transfer &t, size_t i, bool success,
+                                            size_t next) const
+{
+    size_t j = target(t, i);
+
+    switch (t.action) {
+    case Action::NEXT:
+    case Action::LABEL:
+        if (j == stmts.size())
+            return { "return;" };
+        if (j == next)
+            return {};
+        return { "goto L" + std::to_string(j) + ";" };
+    case Action::FRETURN:
+        return { "ctx.rfail = 1;", "return;" };
+    case Action::DYNAMIC:
+        return { "next = ctx.jump(*stmt[" + std::to_string(i) + "], " +
+                     (success ? "true" : "false") + ");",
+                 "goto dispatch;" };
+    default:
+        return { "return;" };
+    }
+}
+
+void Translator::emit_lines(const std::vector<std::string> &lines, const char *indent) const
+{
+    for (const std::string &line : lines)
+        out << indent << line << "\n";
+}
+
+//
+// Write an if statement on the outcome of statement i.
+//
+void Translator::emit_if(const char *cond, size_t i, const std::vector<std::string> &lines) const
+{
+    out << cond << i << "]))";
+    if (lines.size() == 1) {
+        out << "\n";
+        emit_lines(lines, "        ");
+    } else {
+        out << " {\n";
+        emit_lines(lines, "        ");
+        out << "    }\n";
+    }
+}
+
+void Translator::emit_unit(const Unit &unit) const
+{
+    out << "\n//\n// " << unit.comment << "\n//\n";
+    out << "static void " << unit.name << "(SnobolContext &ctx)\n{\n";
+    if (unit.dynamic)
+        out << "    Node *next;\n\n";
+    if (unit.entry != *unit.stmts.begin())
+        out << "    goto L" << unit.entry << ";\n";
+
+    for (size_t i : unit.stmts) {
+        Transfer s = transfer(i, true);
+        Transfer f = transfer(i, false);
+
+        if (unit.targets.count(i))
+            out << "L" << i << ":";
+        if (names.count(i))
+            out << " // " << names.at(i);
+        if (unit.targets.count(i) || names.count(i))
+            out << "\n";
+        if (same(i)) {
+            out << "    ctx.perform(*stmt[" << i << "]);\n";
+            emit_lines(action(s, i, true, follow(unit, i)), "    ");
+            continue;
+        }
+        if (action(f, i, false, follow(unit, i)).empty()) {
+            // Failure falls through, jump on success
+            emit_if("    if (ctx.perform(*stmt[", i, action(s, i, true, stmts.size()));
+            continue;
+        }
+        emit_if("    if (!ctx.perform(*stmt[", i, action(f, i, false, stmts.size()));
+        emit_lines(action(s, i, true, follow(unit, i)), "    ");
+    }
+
+    if (unit.dynamic) {
+        out << "dispatch:\n    if (next == nullptr)\n        return;\n";
+        for (size_t i : labeled)
+            out << "    if (next == stmt[" << i << "])\n        goto L" << i << ";\n";
+        out << "    ctx.writes(\"attempt to transfer to non-label\");\n";
+    }
+    out << "}\n";
+}
+
+void Translator::emit_image() const
+{
+    std::ostringstream image;
+
+    ctx.save_image(image);
+    const std::string bytes = image.str();
+
+    out << "\nstatic const unsigned char image[] = {";
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (i % 16 == 0)
+            out << "\n   ";
+        out << " 0x" << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<unsigned>(static_cast<unsigned char>(bytes[i])) << std::dec << ",";
+    }
+    out << "\n};\n";
+    out << "\nstatic Node *stmt[" << std::max<size_t>(stmts.size(), 1) << "];\n";
+}
+
+void Translator::emit_main() const
+{
+    // Function calls made by the library come back through run_body
+    out << "\nstatic void run_body(SnobolContext &ctx, const Node &body)\n{\n";
+    for (size_t u = 1; u < units.size(); u++) {
+        out << "    if (&body == stmt[" << units[u].entry << "]) {\n"
+            << "        " << units[u].name << "(ctx);\n        return;\n    }\n";
+    }
+    out << "    ctx.writes(\"illegal function\");\n}\n";
+
+    out << "\nint main()\n{\n"
+        << "    SnobolContext ctx(std::cout);\n"
+        << "    size_t i = 0;\n\n"
+        << "    if (!ctx.load_image(image, sizeof(image))) {\n"
+        << "        std::cerr << \"bad image\" << std::endl;\n"
+        << "        return 1;\n"
+        << "    }\n"
+        << "    for (Node *s = ctx.program; s != nullptr; s = s->head)\n"
+        << "        stmt[i++] = s;\n"
+        << "    ctx.run_body = run_body;\n"
+        << "    ctx.fin      = &std::cin;\n";
+    if (ctx.bignums)
+        out << "    ctx.bignums  = true;\n";
+    out << "    ctx.max_depth = " << ctx.max_depth << ";\n";
+    if (ctx.max_steps != 0)
+        out << "    ctx.max_steps = " << ctx.max_steps << ";\n";
+    if (ctx.time_limit != 0)
+        out << "    ctx.time_limit = " << ctx.time_limit << ";\n";
+    out << "    ctx.start_clock();\n";
+    if (!units.empty())
+        out << "    " << units[0].name << "(ctx);\n";
+    out << "    ctx.flush();\n"
+        << "    if (ctx.match_aborts != 0)\n"
+        << "        std::cerr << ctx.match_aborts << \" pattern matches exceeded --steps\" << "
+           "std::endl;\n"
+        << "    return 0;\n"
+        << "}\n";
+}
+
+void Translator::run()
+{
+    for (const Node *s = ctx.program; s != nullptr; s = s->head) {
+        num[s] = stmts.size();
+        stmts.push_back(s);
+    }
+    for (const Node *n = ctx.namelist; n != nullptr; n = n->tail) {
+        const Node *sym = n->head;
+        if (sym->typ == Token::EXPR_LABEL && num.count(sym->tail)) {
+            labeled.push_back(num[sym->tail]);
+            names[num[sym->tail]] = name_of(*sym);
+        }
+    }
+    std::sort(labeled.begin(), labeled.end());
+
+    // The program itself, then each function
+    if (!stmts.empty()) {
+        size_t entry = 0;
+        if (ctx.lookstart->typ == Token::EXPR_LABEL)
+            entry = num.at(ctx.lookstart->tail);
+        units.push_back({ "program", "Main program", entry, {}, {}, false });
+    }
+    for (const Node *n = ctx.namelist; n != nullptr; n = n->tail) {
+        const Node *sym = n->head;
+        if (sym->typ != Token::EXPR_FUNCTION)
+            continue;
+        const Node *body = sym->tail->head->head;
+        if (body == nullptr || num.count(body) == 0)
+            continue;
+        std::string name = name_of(*sym);
+        units.push_back({ identifier("fn", units.size(), name), "Function " + name, num[body],
+                          {}, {}, false });
+    }
+    for (Unit &unit : units) {
+        reach(unit);
+        label(unit);
+    }
+
+    out << "//\n// Translated from Snobol by sno --translate. Do not edit.\n//\n";
+    out << "#include \"sno.h\"\n";
+    emit_image();
+    for (size_t u = 1; u < units.size(); u++)
+        out << "static void " << units[u].name << "(SnobolContext &ctx);\n";
+    for (const Unit &unit : units)
+        emit_unit(unit);
+    emit_main();
+}
+
+} // namespace
+
+//
+// Write the compiled program as a standalone C++ program.
+// Must be called after compile_program() and before execution.
+//
+void SnobolContext::translate(std::ostream &out) const
+{
+    Translator(*this, out).run();
+}
@@ -0,0 +1,338 @@
+//
+// Arbitrary-precision integer arithmetic.
+//
+// When bignums are enabled, arithmetic whose operands or result do not
+// fit in 64 bits is redone here instead of failing the statement.
+// Numbers are held as magnitudes in base 10^9 limbs, least significant
+// first, plus a sign. Multiplication switches from the schoolbook method
+// to Karatsuba once both operands are long enough; division is Knuth's
+// algorithm D. Results are returned as ordinary strings.
+//
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "sno.h"
+
+namespace {
+
+const uint32_t BASE              = 1000000000; // Decimal digits per limb: 9
+const unsigned BASE_DIGITS       = 9;
+const size_t KARATSUBA_THRESHOLD = 32; // Limbs, below this use schoolbook
+
+using Limbs = std::vector<uint32_t>; // No high zero limbs; zero is empty
+
+struct BigInt {
+    bool negative{};
+    Limbs mag;
+};
+
+void trim(Limbs &a)
+{
+    while (!a.empty() && a.back() == 0)
+        a.pop_back();
+}
+
+int compare(const Limbs &a, const Limbs &b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+//
+// Add b into a, starting at limb shift.
+//
+void add_to(Limbs &a, const Limbs &b, size_t shift = 0)
+{
+    uint32_t carry = 0;
+    size_t i;
+
+    if (a.size() < b.size() + shift)
+        a.resize(b.size() + shift, 0);
+    for (i = 0; i < b.size() || carry; i++) {
+        if (i + shift == a.size())
+            a.push_back(0);
+        uint32_t sum = a[i + shift] + carry + (i < b.size() ? b[i] : 0);
+        carry        = sum >= BASE;
+        a[i + shift] = carry ? sum - BASE : sum;
+    }
+}
+
+//
+// Subtract b from a, which must not be smaller.
+//
+void sub_from(Limbs &a, const Limbs &b)
+{
+    int32_t borrow = 0;
+
+    for (size_t i = 0; i < b.size() || borrow; i++) {
+        int32_t diff = static_cast<int32_t>(a[i]) - borrow;
+        if (i < b.size())
+            diff -= static_cast<int32_t>(b[i]);
+        borrow = diff < 0;
+        a[i]   = static_cast<uint32_t>(borrow ? diff + static_cast<int32_t>(BASE) : diff);
+    }
+    trim(a);
+}
+
+Limbs mul_school(const Limbs &a, const Limbs &b)
+{
+    Limbs r(a.size() + b.size(), 0);
+
+    for (size_t i = 0; i < a.size(); i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size() || carry; j++) {
+            uint64_t cur = r[i + j] + carry + (j < b.size() ? uint64_t(a[i]) * b[j] : 0);
+            r[i + j]     = static_cast<uint32_t>(cur % BASE);
+            carry        = cur / BASE;
+        }
+    }
+    trim(r);
+    return r;
+}
+
+//
+// Karatsuba multiplication: with a = a1 B^m + a0 and b = b1 B^m + b0,
+// a b = z2 B^2m + (z1 - z2 - z0) B^m + z0, where z0 = a0 b0, z2 = a1 b1
+// and z1 = (a0 + a1)(b0 + b1), so three half-size products replace four.
+//
+Limbs mul(const Limbs &a, const Limbs &b)
+{
+    if (a.size() < KARATSUBA_THRESHOLD || b.size() < KARATSUBA_THRESHOLD)
+        return mul_school(a, b);
+
+    size_t m = std::max(a.size(), b.size()) / 2;
+    auto low = [m](const Limbs &x) {
+        Limbs r(x.begin(), x.begin() + std::min(m, x.size()));
+        trim(r);
+        return r;
+    };
+    auto high = [m](const Limbs &x) {
+        return x.size() > m ? Limbs(x.begin() + m, x.end()) : Limbs();
+    };
+    Limbs a0 = low(a), a1 = high(a);
+    Limbs b0 = low(b), b1 = high(b);
+    Limbs z0 = mul(a0, b0);
+    Limbs z2 = mul(a1, b1);
+    add_to(a0, a1);
+    add_to(b0, b1);
+    Limbs z1 = mul(a0, b0);
+    sub_from(z1, z0);
+    sub_from(z1, z2);
+
+    Limbs r = z0;
+    add_to(r, z1, m);
+    add_to(r, z2, 2 * m);
+    trim(r);
+    return r;
+}
+
+//
+// Multiply by a single limb in place.
+//
+void mul_small(Limbs &a, uint32_t k)
+{
+    uint64_t carry = 0;
+
+    for (uint32_t &limb : a) {
+        uint64_t cur = uint64_t(limb) * k + carry;
+        limb         = static_cast<uint32_t>(cur % BASE);
+        carry        = cur / BASE;
+    }
+    if (carry)
+        a.push_back(static_cast<uint32_t>(carry));
+}
+
+//
+// Quotient of two magnitudes, truncated. The divisor must not be zero.
+//
+Limbs quotient(const Limbs &a, const Limbs &b)
+{
+    Limbs q;
+
+    if (compare(a, b) < 0)
+        return q;
+    q.assign(a.size(), 0);
+
+    if (b.size() == 1) {
+        // Short division
+        uint64_t rem = 0;
+        for (size_t i = a.size(); i-- > 0;) {
+            uint64_t cur = a[i] + rem * BASE;
+            q[i]         = static_cast<uint32_t>(cur / b[0]);
+            rem          = cur % b[0];
+        }
+        trim(q);
+        return q;
+    }
+
+    // Knuth, TAOCP vol. 2, 4.3.1, algorithm D
+    uint32_t d = BASE / (b.back() + 1); // Normalize so the top divisor limb is large
+    Limbs u = a, v = b;
+    mul_small(u, d);
+    mul_small(v, d);
+    u.resize(a.size() + 1, 0);
+    size_t n = v.size();
+
+    for (size_t j = u.size() - n; j-- > 0;) {
+        uint64_t num  = uint64_t(u[j + n]) * BASE + u[j + n - 1];
+        uint64_t qhat = num / v[n - 1];
+        uint64_t rhat = num % v[n - 1];
+        while (qhat >= BASE || qhat * v[n - 2] > rhat * BASE + u[j + n - 2]) {
+            qhat--;
+            rhat += v[n - 1];
+            if (rhat >= BASE)
+                break;
+        }
+
+        // Multiply and subtract qhat * v from u[j .. j+n]
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i <= n; i++) {
+            uint64_t p = carry + (i < n ? qhat * v[i] : 0);
+            carry      = p / BASE;
+            int64_t t  = int64_t(u[i + j]) - int64_t(p % BASE) - borrow;
+            borrow     = t < 0;
+            u[i + j]   = static_cast<uint32_t>(borrow ? t + BASE : t);
+        }
+        if (borrow) {
+            // qhat was one too large, add the divisor back
+            qhat--;
+            uint32_t c = 0;
+            for (size_t i = 0; i <= n; i++) {
+                uint32_t sum = u[i + j] + c + (i < n ? v[i] : 0);
+                c            = sum >= BASE;
+                u[i + j]     = c ? sum - BASE : sum;
+            }
+        }
+        q[j] = static_cast<uint32_t>(qhat);
+    }
+    trim(q);
+    return q;
+}
+
+//
+// Read a number from a string value.
+// Returns false if it is not an integer string.
+//
+bool parse(const Node *s, BigInt &r)
+{
+    std::vector<char> digits;
+
+    r = BigInt();
+    if (s == nullptr)
+        return true;
+    for (const Node *p = s; p != s->tail;) {
+        p = p->head;
+        if (p->ch == '-' && p == s->head && p != s->tail)
+            r.negative = true;
+        else if (p->ch >= '0' && p->ch <= '9')
+            digits.push_back(p->ch);
+        else
+            return false;
+    }
+    for (size_t end = digits.size(); end > 0;) {
+        size_t start  = end > BASE_DIGITS ? end - BASE_DIGITS : 0;
+        uint32_t limb = 0;
+        for (size_t i = start; i < end; i++)
+            limb = limb * 10 + (digits[i] - '0');
+        r.mag.push_back(limb);
+        end = start;
+    }
+    trim(r.mag);
+    if (r.mag.empty())
+        r.negative = false;
+    return true;
+}
+
+//
+// Signed sum, using the magnitudes.
+//
+BigInt signed_add(const BigInt &a, const BigInt &b)
+{
+    BigInt r;
+
+    if (a.negative == b.negative) {
+        r = a;
+        add_to(r.mag, b.mag);
+        return r;
+    }
+    if (compare(a.mag, b.mag) >= 0) {
+        r = a;
+        sub_from(r.mag, b.mag);
+    } else {
+        r = b;
+        sub_from(r.mag, a.mag);
+    }
+    if (r.mag.empty())
+        r.negative = false;
+    return r;
+}
+
+} // namespace
+
+//
+// Apply an arithmetic operator to two integer strings of any length.
+// Division truncates toward zero like machine arithmetic; division by
+// zero fails the statement. Returns the result as a string.
+//
+Node *SnobolContext::bigop(Token op, const Node &arg1, const Node &arg2)
+{
+    BigInt a, b, r;
+    Node *s, *q;
+    char buf[BASE_DIGITS];
+
+    if (!parse(text(&arg1), a) || !parse(text(&arg2), b)) {
+        writes("bad integer string");
+        return &integer(0);
+    }
+    switch (op) {
+    case Token::TOKEN_PLUS:
+        r = signed_add(a, b);
+        break;
+    case Token::TOKEN_MINUS:
+        b.negative = !b.negative && !b.mag.empty();
+        r          = signed_add(a, b);
+        break;
+    case Token::TOKEN_MULT:
+        r.mag      = mul(a.mag, b.mag);
+        r.negative = a.negative != b.negative && !r.mag.empty();
+        break;
+    case Token::TOKEN_DIV:
+        if (b.mag.empty()) {
+            rfail = 1;
+            return &integer(0);
+        }
+        r.mag      = quotient(a.mag, b.mag);
+        r.negative = a.negative != b.negative && !r.mag.empty();
+        break;
+    default:
+        return nullptr;
+    }
+    if (r.mag.empty())
+        return &integer(0);
+
+    // Format the top limb without padding, the others with nine digits
+    s = text(&binstr(r.negative ? -int64_t(r.mag.back()) : int64_t(r.mag.back())));
+    q = s->tail;
+    for (size_t i = r.mag.size() - 1; i-- > 0;) {
+        uint32_t limb = r.mag[i];
+        for (unsigned k = BASE_DIGITS; k-- > 0;) {
+            buf[k] = static_cast<char>('0' + limb % 10);
+            limb /= 10;
+        }
+        for (char c : buf) {
+            Node *m = &alloc();
+            m->ch   = c;
+            q->head = m;
+            q       = m;
+        }
+    }
+    s->tail = q;
+    return s;
+}
@@ -0,0 +1,335 @@
+//
+// Static type inference for integer-only variables.
+//
+// After compilation every expression of the program is typed: statement
+// subjects and values, pattern components, gotos and function bodies.
+// A variable gets the join of the types of everything that can be
+// stored in it, by assignment, by binding a parameter to an argument at
+// a call site, or as the return value of a function. Types of variables
+// feed back into expressions, so this is repeated until nothing changes.
+// The analysis does not depend on the order statements run in, so gotos
+// computed at run time need no special care; a store through $ can reach
+// any variable, and then nothing is specialised.
+//
+// Arithmetic on integers and concatenation with an integer are then
+// retyped to the specialised operators of eval(), and integer-only
+// variables are marked so that their values stay binary, see
+// int_operand(). Anything else keeps the generic path.
+//
+#include <map>
+#include <vector>
+
+#include "sno.h"
+
+namespace {
+
+//
+// Types in increasing order, so the join of two types is the larger one.
+//
+enum class Type {
+    NONE,    // Nothing stored yet
+    INTEGER, // Integers, in the form arithmetic produces
+    STRING,  // Anything
+};
+
+struct Value {
+    Type type;
+    Node *sym;    // Symbol of a variable reference, or null
+    bool dynamic; // Variable reference made by $
+};
+
+class Inference {
+public:
+    explicit Inference(SnobolContext &ctx) : ctx(ctx) {}
+    void run();
+
+private:
+    SnobolContext &ctx;
+    std::map<const Node *, Type> types; // Variables and function return values
+    bool changed{};
+    bool unknown{}; // A store to a variable not known at compile time
+    bool rewrite{}; // Specialise operators while typing
+
+    Type type_of(const Node *sym) const;
+    void store(Node *sym, Type type);
+    Value walk(Node *list);
+    void call(Node *op, Value &callee);
+    void target(Node *list, Type type);
+    void pattern(const Node &m);
+    void statement(const Node &e);
+};
+
+//
+// Check whether a literal is an integer in the form arithmetic produces,
+// so keeping it as a binary integer cannot change how it prints.
+//
+bool is_number(const Node *string)
+{
+    const Node *p;
+
+    if (string == nullptr)
+        return false;
+    p = string->head;
+    if (p->ch == '-') {
+        if (p == string->tail || p->head->ch == '0')
+            return false;
+        p = p->head;
+    }
+    if (p->ch == '0' && p != string->tail)
+        return false;
+    for (;;) {
+        if (p->ch < '0' || p->ch > '9')
+            return false;
+        if (p == string->tail)
+            return true;
+        p = p->head;
+    }
+}
+
+//
+// Get the specialised form of an arithmetic operator.
+//
+Token specialise(Token op)
+{
+    switch (op) {
+    case Token::TOKEN_PLUS:
+        return Token::TOKEN_INT_PLUS;
+    case Token::TOKEN_MINUS:
+        return Token::TOKEN_INT_MINUS;
+    case Token::TOKEN_MULT:
+        return Token::TOKEN_INT_MULT;
+    case Token::TOKEN_DIV:
+        return Token::TOKEN_INT_DIV;
+    default:
+        return op;
+    }
+}
+
+//
+// Get the type of the values held by a symbol.
+// Only variables and functions can be stored to.
+//
+Type Inference::type_of(const Node *sym) const
+{
+    switch (sym->typ) {
+    case Token::EXPR_VAR_REF:
+    case Token::EXPR_VALUE:
+    case Token::EXPR_FUNCTION: {
+        auto it = types.find(sym);
+        return it == types.end() ? Type::NONE : it->second;
+    }
+    default: // syspit, labels
+        return Type::STRING;
+    }
+}
+
+void Inference::store(Node *sym, Type type)
+{
+    if (sym->typ != Token::EXPR_VAR_REF && sym->typ != Token::EXPR_VALUE &&
+        sym->typ != Token::EXPR_FUNCTION)
+        return;
+    Type &t = types[sym];
+    if (type > t) {
+        t       = type;
+        changed = true;
+    }
+}
+
+//
+// Type an expression list, following the postfix order of eval().
+// Returns the type of the result.
+//
+Value Inference::walk(Node *list)
+{
+    std::vector<Value> stack;
+    Value a, b;
+
+    auto pop = [&stack]() {
+        Value v{ Type::STRING, nullptr, false };
+        if (!stack.empty()) {
+            v = stack.back();
+            stack.pop_back();
+        }
+        return v;
+    };
+
+    for (;; list = list->head) {
+        switch (list->typ) {
+        case Token::TOKEN_STRING:
+            stack.push_back({ is_number(list->tail) ? Type::INTEGER : Type::STRING, nullptr, false });
+            break;
+        case Token::TOKEN_VARIABLE:
+            stack.push_back({ type_of(list->tail), list->tail, false });
+            break;
+        case Token::TOKEN_DOLLAR:
+            pop();
+            stack.push_back({ Type::STRING, nullptr, true });
+            break;
+        case Token::TOKEN_CALL:
+            a = pop();
+            call(list, a);
+            stack.push_back(a);
+            break;
+        case Token::TOKEN_PLUS:
+        case Token::TOKEN_MINUS:
+        case Token::TOKEN_MULT:
+        case Token::TOKEN_DIV:
+        case Token::TOKEN_INT_PLUS:
+        case Token::TOKEN_INT_MINUS:
+        case Token::TOKEN_INT_MULT:
+        case Token::TOKEN_INT_DIV:
+            b = pop();
+            a = pop();
+            if (rewrite && a.type != Type::STRING && b.type != Type::STRING)
+                list->typ = specialise(list->typ);
+            stack.push_back({ Type::INTEGER, nullptr, false });
+            break;
+        case Token::TOKEN_WHITESPACE:
+        case Token::TOKEN_INT_CAT:
+            b = pop();
+            a = pop();
+            if (rewrite && (a.type == Type::INTEGER || b.type == Type::INTEGER))
+                list->typ = Token::TOKEN_INT_CAT;
+            stack.push_back({ Type::STRING, nullptr, false });
+            break;
+        default: // End of expression
+            return stack.empty() ? Value{ Type::STRING, nullptr, false } : stack.back();
+        }
+    }
+}
+
+//
+// Bind the parameters of a called function to the types of the arguments.
+// The callee becomes the function's return value.
+//
+void Inference::call(Node *op, Value &callee)
+{
+    Node *f     = callee.sym;
+    Node *param = nullptr;
+    Node *arg;
+    Type t;
+
+    if (f == nullptr || f->typ != Token::EXPR_FUNCTION)
+        unknown = true; // Parameters can not be found
+    else
+        param = f->tail->tail;
+    for (arg = op->tail; arg != nullptr; arg = arg->head) {
+        t = walk(arg->tail).type;
+        if (param != nullptr) {
+            store(param->head, t);
+            param = param->tail;
+        }
+    }
+    callee = { f != nullptr ? type_of(f) : Type::STRING, nullptr, false };
+}
+
+//
+// Type the target of a store.
+//
+void Inference::target(Node *list, Type type)
+{
+    Value v = walk(list);
+
+    if (v.dynamic)
+        unknown = true;
+    else if (v.sym != nullptr)
+        store(v.sym, type);
+}
+
+//
+// Type the components of a pattern. Variables assigned by
+// *x* components receive parts of the subject.
+//
+void Inference::pattern(const Node &m)
+{
+    const Node *a;
+    Node *b;
+
+    for (a = m.tail; a->typ != Token::TOKEN_END; a = a->head) {
+        b = a->tail;
+        if (a->typ == Token::TOKEN_UNANCHORED) {
+            walk(b);
+            continue;
+        }
+        if (b->head != nullptr)
+            target(b->head, Type::STRING);
+        if (b->tail != nullptr)
+            walk(b->tail);
+    }
+}
+
+//
+// Type the expressions of a compiled statement, see compile() for the layout.
+// Fused statements keep the layout of the statement they replace.
+//
+void Inference::statement(const Node &e)
+{
+    Node *r = e.tail;
+    Node *g;
+
+    switch (e.typ) {
+    case Token::STMT_SIMPLE: // r g
+        walk(r->tail);
+        g = r->head;
+        break;
+    case Token::STMT_MATCH: // r m g
+    case Token::STMT_FIND:
+        walk(r->tail);
+        pattern(*r->head);
+        g = r->head->head;
+        break;
+    case Token::STMT_REPLACE: // r m a g
+    case Token::STMT_GLOBAL:
+        pattern(*r->head);
+        walk(r->head->head->tail);
+        target(r->tail, Type::STRING);
+        g = r->head->head->head;
+        break;
+    default: // r a g
+        target(r->tail, walk(r->head->tail).type);
+        g = r->head->head;
+        break;
+    }
+    if (g->head != nullptr)
+        walk(g->head);
+    if (g->tail != nullptr && g->tail != g->head)
+        walk(g->tail);
+}
+
+void Inference::run()
+{
+    const Node *e;
+    Node *i, *sym;
+
+    do {
+        changed = false;
+        for (e = ctx.program; e != nullptr && !unknown; e = e->head)
+            statement(*e);
+    } while (changed && !unknown);
+
+    if (unknown) {
+        types.clear();
+    } else {
+        rewrite = true;
+        for (e = ctx.program; e != nullptr; e = e->head)
+            statement(*e);
+    }
+    for (i = ctx.namelist; i != nullptr; i = i->tail) {
+        sym     = i->head;
+        sym->ch = (sym->typ == Token::EXPR_VAR_REF || sym->typ == Token::EXPR_VALUE) &&
+                          type_of(sym) == Type::INTEGER
+                      ? SnobolContext::INTEGER_VARIABLE
+                      : 0;
+    }
+}
+
+} // namespace
+
+//
+// Infer integer-only variables and specialise the compiled program.
+// Called by compile_program() when inference is enabled.
+//
+void SnobolContext::infer()
+{
+    Inference(*this).run();
+}
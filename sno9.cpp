@@ -0,0 +1,321 @@
+//
+// Memoization of functions declared with memo.
+//
+//     define  f(x) memo
+//
+// A call to such a function first looks up the values of its arguments
+// in a table of earlier results, and runs the body only when they are
+// not there. The table keeps the memo_size most recently used results.
+//
+// Caching is only correct when the result depends on nothing but the
+// arguments, so after compilation memoize() checks every statement the
+// body can reach: it may use its parameters and locals, its own value
+// and labels, and call functions that are pure in the same sense.
+// Input, output, other variables, $ and computed gotos turn caching
+// off again.
+//
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "sno.h"
+
+namespace {
+
+//
+// What a function body does, as far as purity is concerned.
+//
+struct Body {
+    bool impure;                      // Touches something besides its own variables
+    std::vector<const Node *> callee; // Name nodes of the functions it calls
+};
+
+class Purity {
+public:
+    explicit Purity(SnobolContext &ctx) : ctx(ctx) {}
+    void run();
+
+private:
+    SnobolContext &ctx;
+    std::map<const Node *, Body> bodies; // By function name node
+
+    bool local(const Node &fn, const Node *sym) const;
+    bool expression(const Node &fn, const Node *list, Body &body) const;
+    bool pattern(const Node &fn, const Node &m, Body &body) const;
+    const Node *successor(const Node *list, const Node *next, bool &pure) const;
+    Body scan(const Node &fn) const;
+};
+
+//
+// Check whether a function may use a symbol without depending on anything
+// but its arguments: its parameters and locals, its own value, and labels.
+//
+bool Purity::local(const Node &fn, const Node *sym) const
+{
+    const Node *p;
+
+    if (sym->typ == Token::EXPR_LABEL || sym == ctx.lookret || sym == ctx.lookfret)
+        return true;
+    if (sym->typ == Token::EXPR_FUNCTION && sym->tail == &fn)
+        return true;
+    for (p = fn.tail; p != nullptr; p = p->tail)
+        if (p->head == sym)
+            return true;
+    return false;
+}
+
+//
+// Scan an expression list, collecting called functions.
+// Returns false if it uses anything else.
+//
+bool Purity::expression(const Node &fn, const Node *list, Body &body) const
+{
+    const Node *arg, *sym;
+
+    for (;; list = list->head) {
+        switch (list->typ) {
+        case Token::TOKEN_VARIABLE:
+            sym = list->tail;
+            if (list->head->typ == Token::TOKEN_CALL) {
+                if (sym->typ != Token::EXPR_FUNCTION)
+                    return false;
+                body.callee.push_back(sym->tail);
+            } else if (!local(fn, sym)) {
+                return false;
+            }
+            break;
+        case Token::TOKEN_CALL:
+            for (arg = list->tail; arg != nullptr; arg = arg->head)
+                if (!expression(fn, arg->tail, body))
+                    return false;
+            break;
+        case Token::TOKEN_DOLLAR:
+            return false;
+        case Token::TOKEN_STRING:
+        case Token::TOKEN_WHITESPACE:
+        case Token::TOKEN_PLUS:
+        case Token::TOKEN_MINUS:
+        case Token::TOKEN_MULT:
+        case Token::TOKEN_DIV:
+        case Token::TOKEN_INT_PLUS:
+        case Token::TOKEN_INT_MINUS:
+        case Token::TOKEN_INT_MULT:
+        case Token::TOKEN_INT_DIV:
+        case Token::TOKEN_INT_CAT:
+            break;
+        default: // End of expression
+            return true;
+        }
+    }
+}
+
+//
+// Scan the components of a pattern, see Inference::pattern().
+//
+bool Purity::pattern(const Node &fn, const Node &m, Body &body) const
+{
+    const Node *a, *b;
+
+    for (a = m.tail; a->typ != Token::TOKEN_END; a = a->head) {
+        b = a->tail;
+        if (a->typ == Token::TOKEN_UNANCHORED) {
+            if (!expression(fn, b, body))
+                return false;
+            continue;
+        }
+        if (b->head != nullptr && !expression(fn, b->head, body))
+            return false;
+        if (b->tail != nullptr && !expression(fn, b->tail, body))
+            return false;
+    }
+    return true;
+}
+
+//
+// Find where a goto leads: the statement after a missing goto, the
+// statement of a label, or nothing for return and freturn. Clears
+// pure for gotos computed at run time.
+//
+const Node *Purity::successor(const Node *list, const Node *next, bool &pure) const
+{
+    const Node *sym;
+
+    if (list == nullptr)
+        return next;
+    sym = list->tail;
+    if (list->typ != Token::TOKEN_VARIABLE || list->head->typ != Token::TOKEN_END) {
+        pure = false;
+    } else if (sym->typ == Token::EXPR_LABEL) {
+        return sym->tail;
+    } else if (sym != ctx.lookret && sym != ctx.lookfret) {
+        pure = false;
+    }
+    return nullptr;
+}
+
+//
+// Scan the statements a function body can reach.
+// Fused statements keep the layout of the statement they replace.
+//
+Body Purity::scan(const Node &fn) const
+{
+    std::vector<const Node *> work;
+    std::vector<const Node *> seen;
+    Body body{ false, {} };
+    const Node *e, *r, *g;
+    bool pure = true;
+
+    work.push_back(fn.head->head);
+    while (pure && !work.empty()) {
+        e = work.back();
+        work.pop_back();
+        if (e == nullptr || std::find(seen.begin(), seen.end(), e) != seen.end())
+            continue;
+        seen.push_back(e);
+        r = e->tail;
+        switch (e->typ) {
+        case Token::STMT_SIMPLE: // r g
+            pure = expression(fn, r->tail, body);
+            g    = r->head;
+            break;
+        case Token::STMT_MATCH: // r m g
+        case Token::STMT_FIND:
+            pure = expression(fn, r->tail, body) && pattern(fn, *r->head, body);
+            g    = r->head->head;
+            break;
+        case Token::STMT_REPLACE: // r m a g
+        case Token::STMT_GLOBAL:
+            pure = expression(fn, r->tail, body) && pattern(fn, *r->head, body) &&
+                   expression(fn, r->head->head->tail, body);
+            g = r->head->head->head;
+            break;
+        default: // r a g
+            pure = expression(fn, r->tail, body) && expression(fn, r->head->tail, body);
+            g    = r->head->head;
+            break;
+        }
+        work.push_back(successor(g->head, e->head, pure));
+        work.push_back(successor(g->tail, e->head, pure));
+    }
+    body.impure = !pure;
+    return body;
+}
+
+void Purity::run()
+{
+    Node *i, *sym;
+    bool changed;
+
+    for (i = ctx.namelist; i != nullptr; i = i->tail) {
+        sym = i->head;
+        if (sym->typ == Token::EXPR_FUNCTION)
+            bodies[sym->tail] = scan(*sym->tail);
+    }
+
+    // A function calling an impure function is impure
+    do {
+        changed = false;
+        for (auto &entry : bodies) {
+            if (entry.second.impure)
+                continue;
+            for (const Node *callee : entry.second.callee) {
+                auto it = bodies.find(callee);
+                if (it == bodies.end() || it->second.impure) {
+                    entry.second.impure = true;
+                    changed             = true;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+
+    for (i = ctx.namelist; i != nullptr; i = i->tail) {
+        sym = i->head;
+        if (sym->typ == Token::EXPR_FUNCTION && bodies[sym->tail].impure)
+            sym->tail->ch = 0;
+    }
+}
+
+//
+// Append the characters of a string to a key or cached value.
+//
+void append(SnobolContext &ctx, std::string &out, const Node *string)
+{
+    const Node *a;
+
+    if (string == nullptr)
+        return;
+    if (string->typ == Token::EXPR_INTEGER) {
+        out += std::to_string(ctx.strbin(string));
+        return;
+    }
+    for (a = string; a != string->tail;) {
+        a = a->head;
+        out += a->ch;
+    }
+}
+
+} // namespace
+
+//
+// Turn off caching for memo functions that are not pure.
+// Called by compile_program().
+//
+void SnobolContext::memoize()
+{
+    Purity(*this).run();
+}
+
+//
+// Look up the result of a call to memo function fn, whose parameters
+// are bound to the arguments. Returns 1 and a copy of the value if it
+// succeeded, -1 if it failed, or 0 if the call must run: remember()
+// then stores its result.
+//
+int SnobolContext::recall(const Node &fn, Node *&value)
+{
+    std::string key;
+    const Node *p;
+    size_t mark;
+
+    for (p = fn.tail; p != nullptr && p->typ == Token::EXPR_VAR_REF; p = p->tail) {
+        // Prefix each value by its length, so the key is unambiguous
+        mark = key.size();
+        append(*this, key, p->head->tail);
+        key.insert(mark, std::to_string(key.size() - mark) + ":");
+    }
+
+    MemoTable &table = memos[&fn];
+    auto it          = table.index.find(key);
+    if (it == table.index.end()) {
+        memo_calls.push_back({ &fn, std::move(key) });
+        return 0;
+    }
+    table.entries.splice(table.entries.begin(), table.entries, it->second);
+    const MemoResult &result = it->second->second;
+    value = result.value.empty() ? nullptr : &cstr_to_node(result.value.c_str());
+    return result.failed ? -1 : 1;
+}
+
+//
+// Store the result of the call of the innermost frame with memo set.
+// The least recently used result makes room when the table is full.
+//
+void SnobolContext::remember(const Node *value, bool failed)
+{
+    MemoCall call    = std::move(memo_calls.back());
+    MemoTable &table = memos[call.fn];
+    MemoResult result{ {}, failed };
+
+    memo_calls.pop_back();
+    if (memo_size == 0 || table.index.count(call.key) != 0)
+        return; // Stored by a recursive call with the same arguments
+    if (!failed)
+        append(*this, result.value, value);
+    if (table.entries.size() >= memo_size) {
+        table.index.erase(table.entries.back().first);
+        table.entries.pop_back();
+    }
+    table.entries.emplace_front(std::move(call.key), std::move(result));
+    table.index[table.entries.front().first] = table.entries.begin();
+}
@@ -1,4 +1,9 @@
 #include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
 
 #include "sno.h"
 #include "test_helpers.h"
@@ -571,3 +576,764 @@ TEST_F(SnobolTest, Look_SameNameReturnsSameSymbol)
     ctx.delete_string(&str1);
     ctx.delete_string(&str2);
 }
+
+// ============================================================================
+// Constant Folding Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Fold_LiteralArithmetic)
+{
+    std::istringstream source("start  x = \"10\" * \"60\" + \"5\"\nend    x = \"1\"\n");
+    ctx.compile_program(source);
+
+    // Assignment value is a single literal followed by the end marker
+    Node *list = ctx.program->tail->head->tail;
+    EXPECT_EQ(list->typ, Token::TOKEN_STRING);
+    EXPECT_TRUE(node_equals_cstr(list->tail, "605"));
+    EXPECT_EQ(list->head->typ, Token::TOKEN_END);
+}
+
+TEST_F(SnobolTest, Fold_LiteralConcatenation)
+{
+    std::istringstream source("start  x = \"prefix\" \"-\" \"suffix\"\nend    x = \"1\"\n");
+    ctx.compile_program(source);
+
+    Node *list = ctx.program->tail->head->tail;
+    EXPECT_EQ(list->typ, Token::TOKEN_STRING);
+    EXPECT_TRUE(node_equals_cstr(list->tail, "prefix-suffix"));
+    EXPECT_EQ(list->head->typ, Token::TOKEN_END);
+}
+
+TEST_F(SnobolTest, Fold_KeepsVariablesAndBadIntegers)
+{
+    std::istringstream source("start  x = y + \"1\" * \"2\" \"a\" + \"1\"\nend    x = \"1\"\n");
+    ctx.inference = false; // Keep the generic operators
+    ctx.compile_program(source);
+
+    // Only "1" * "2" folds: y "2" + "a" "1" + concatenation
+    Node *list = ctx.program->tail->head->tail;
+    EXPECT_EQ(list->typ, Token::TOKEN_VARIABLE);
+    list = list->head;
+    EXPECT_EQ(list->typ, Token::TOKEN_STRING);
+    EXPECT_TRUE(node_equals_cstr(list->tail, "2"));
+    EXPECT_EQ(list->head->typ, Token::TOKEN_PLUS);
+}
+
+// ============================================================================
+// Program Image Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Image_RoundTrip)
+{
+    std::istringstream source(R"(define  twice(x)
+        twice = x x             /(return)
+start   line = syspit           /f(done)
+        syspot = twice(line)    /(start)
+done    syspot = "done"
+end     syspot = "end"
+)");
+    ctx.compile_program(source);
+
+    char path[] = "/tmp/snobol_image_XXXXXX";
+    int fd      = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream image(path, std::ios::binary);
+        ctx.save_image(image);
+    }
+    EXPECT_TRUE(SnobolContext::is_image(path));
+
+    std::stringstream output;
+    std::istringstream input("ab\ncd\n");
+    SnobolContext loaded(output);
+    ASSERT_TRUE(loaded.load_image(path));
+    loaded.execute_program(input);
+    unlink(path);
+
+    EXPECT_EQ(output.str(), "abab\ncdcd\ndone\nend\n");
+}
+
+TEST_F(SnobolTest, Image_RejectsSource)
+{
+    char path[] = "/tmp/snobol_source_XXXXXX";
+    int fd      = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, "end  x = \"1\"\n", 13), 13);
+    close(fd);
+
+    EXPECT_FALSE(SnobolContext::is_image(path));
+    EXPECT_FALSE(ctx.load_image(path));
+    unlink(path);
+}
+
+// ============================================================================
+// Superinstruction Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Fuse_RecognizesShapes)
+{
+    std::istringstream source(R"(start  x = syspit
+       syspot = x
+       syspot = "lit"
+       n = n + "1"
+       x "lit"
+       x = x "1"
+end    x "a" y
+)");
+    ctx.compile_program(source);
+
+    Node *stmt = ctx.program;
+    EXPECT_EQ(stmt->typ, Token::STMT_READ);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_WRITE);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_WRITE);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_INCR);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_FIND);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_ASSIGN);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_MATCH);
+}
+
+TEST_F(SnobolTest, Fuse_Disabled)
+{
+    std::istringstream source("start  n = n + \"1\"\nend    syspot = n\n");
+    ctx.superinstructions = false;
+    ctx.compile_program(source);
+
+    EXPECT_EQ(ctx.program->typ, Token::STMT_ASSIGN);
+}
+
+TEST_F(SnobolTest, Fuse_RecognizesTailCalls)
+{
+    std::istringstream source(R"(define  f(x)
+        f = f(x)                /(return)
+        f = f(x)                /s(return)f(freturn)
+        f = f(x)                /s(return)
+        f = f(x) x              /(return)
+        f = f(f(x))             /(freturn)
+start   syspot = f("a")
+end     return
+)");
+    ctx.compile_program(source);
+
+    Node *stmt = ctx.program;
+    EXPECT_EQ(stmt->typ, Token::STMT_TAIL);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_TAIL);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_ASSIGN);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_ASSIGN);
+    EXPECT_EQ((stmt = stmt->head)->typ, Token::STMT_ASSIGN);
+}
+
+TEST_F(SnobolTest, Tail_ReusesFrame)
+{
+    std::istringstream source(R"(define  count(n,acc)
+        n "-"                   /s(done)
+        count = count(n - "1", acc "a")   /(return)
+done    count = acc             /(return)
+start   syspot = count("1000", "") n
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.max_depth = 1;
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), std::string(1001, 'a') + "\n");
+    EXPECT_TRUE(ctx.frames.empty());
+    EXPECT_TRUE(ctx.bindings.empty());
+}
+
+TEST_F(SnobolTest, Memo_OnlyPureFunctions)
+{
+    std::istringstream source(R"(define  pure(x) memo
+        x "a"                   /s(yes)
+        pure = helper(x)        /(return)
+yes     pure = x x              /(return)
+define  helper(y)
+        helper = y "."          /(return)
+define  calls(x) memo
+        calls = output(x)       /(return)
+define  output(y)
+        syspot = y              /(return)
+define  global(x) memo
+        global = x g            /(return)
+define  computed(x) memo
+        computed = x            /($x)
+define  plain(x)
+        plain = x               /(return)
+start   syspot = pure("b")
+end     return
+)");
+    ctx.compile_program(source);
+
+    auto memo = [this](const char *name) {
+        return ctx.look(ctx.cstr_to_node(name)).tail->ch == SnobolContext::MEMO_FUNCTION;
+    };
+    EXPECT_TRUE(memo("pure"));
+    EXPECT_FALSE(memo("calls"));
+    EXPECT_FALSE(memo("global"));
+    EXPECT_FALSE(memo("computed"));
+    EXPECT_FALSE(memo("plain"));
+}
+
+TEST_F(SnobolTest, Memo_EvictsLeastRecentlyUsed)
+{
+    std::istringstream source(R"(define  f(x) memo
+        x "-"                   /s(freturn)
+        f = x x                 /(return)
+start   syspot = f("1") f("2") f("1") f("3")
+        syspot = f("-1")        /s(end)
+        syspot = f("-1")        /s(end)
+        syspot = "failed"
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.memo_size = 3;
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "11221133\nfailed\n");
+    MemoTable &table = ctx.memos[ctx.look(ctx.cstr_to_node("f")).tail];
+    ASSERT_EQ(table.entries.size(), 3u);
+    EXPECT_EQ(table.entries.front().first, "2:-1");
+    EXPECT_TRUE(table.entries.front().second.failed);
+    EXPECT_EQ(table.index.count("1:2"), 0u); // Least recently used
+    EXPECT_EQ(table.index.count("1:1"), 1u);
+    EXPECT_TRUE(ctx.memo_calls.empty());
+}
+
+TEST_F(SnobolTest, Patterns_CompiledOnce)
+{
+    std::istringstream source(R"(start   str = "abcabc"
+        p = "z"
+        n = "0"
+loop    str "a" *x* "c"
+        str *"q"/p*             /f(next)
+        syspot = n
+next    p = "b"
+        n = n + "1"
+        n "3"                   /f(loop)
+end     syspot = x
+)");
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "1\n2\nb\n");
+    ASSERT_EQ(ctx.patterns.size(), 2u); // n "3" is fused, see fuse()
+    size_t dynamic = 0;
+    for (auto &entry : ctx.patterns)
+        dynamic += entry.second.dynamic;
+    EXPECT_EQ(dynamic, 1u);
+}
+
+TEST_F(SnobolTest, Patterns_MinimumLength)
+{
+    std::istringstream source(R"(start   str = "xxabc"
+        str "a" *(y)* "c"
+        syspot = y
+        str *(z)* "bc"
+        syspot = z
+        str *k* "," *(v)* "," *w*   /s(end)
+        long = "xabcd"
+        str *("abcdef"/long)*       /f(end)
+        syspot = "long"
+end     syspot = "done"
+)");
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "b\nxxa\ndone\n");
+    std::vector<int> minimums;
+    for (auto &entry : ctx.patterns)
+        if (!entry.second.dynamic)
+            minimums.push_back(entry.second.minimum);
+    std::sort(minimums.begin(), minimums.end());
+    EXPECT_EQ(minimums, (std::vector<int>{ 3, 3, 3 }));
+}
+
+TEST_F(SnobolTest, MatchState_NestedSearches)
+{
+    std::istringstream source(R"(define  second(s)
+        s *a* sep *b*           /f(freturn)
+        second = b              /(return)
+start   sep = ","
+        str = "a2b2c"
+        str *p* second("1,2") *q*
+        syspot = p "|" q
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "a|b2c\n");
+    EXPECT_TRUE(ctx.match_components.empty()); // Both searches popped their state
+    EXPECT_TRUE(ctx.match_skips.empty());
+    EXPECT_TRUE(ctx.match_choices.empty());
+    EXPECT_NE(ctx.match_components.capacity(), 0u); // Kept for the next search
+}
+
+TEST_F(SnobolTest, Locals_FollowParameters)
+{
+    std::istringstream source(R"(define  f(a,b)i, j memo
+        i = a b
+        f = i                   /(return)
+start   syspot = f("x", "y") i
+end     return
+)");
+    ctx.compile_program(source);
+
+    Node *fn = ctx.look(ctx.cstr_to_node("f")).tail;
+    std::string names;
+    for (Node *p = fn->tail; p != nullptr; p = p->tail)
+        names += p->typ == Token::EXPR_VALUE ? "local " : "param ";
+    EXPECT_EQ(names, "param param local local ");
+    EXPECT_EQ(fn->ch, SnobolContext::MEMO_FUNCTION); // Locals keep it pure
+
+    ctx.execute_program(input_stream);
+    EXPECT_EQ(output_stream.str(), "xy\n");
+    EXPECT_TRUE(ctx.bindings.empty());
+}
+
+// ============================================================================
+// Translation Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Translate_StaticGotos)
+{
+    std::istringstream source(R"(define  twice(x)
+        twice = x x             /(return)
+start   line = syspit           /f(done)
+        syspot = twice(line)    /(start)
+done    syspot = "done"
+end     syspot = "end"
+)");
+    ctx.compile_program(source);
+
+    std::ostringstream code;
+    ctx.translate(code);
+    EXPECT_NE(code.str().find("static void program(SnobolContext &ctx)"), std::string::npos);
+    EXPECT_NE(code.str().find("static void fn1_twice(SnobolContext &ctx)"), std::string::npos);
+    EXPECT_NE(code.str().find("goto L1;"), std::string::npos);
+    EXPECT_EQ(code.str().find("ctx.jump"), std::string::npos);
+}
+
+TEST_F(SnobolTest, Translate_BuildsAndRuns)
+{
+    std::istringstream source(R"(define  sign(n)
+        n "-"                   /s(freturn)
+        sign = "+"              /(return)
+start   line = syspit           /f(done)
+        k = "neg"
+        syspot = sign(line) line /s(start)f($k)
+neg     syspot = "-" line       /(start)
+done    syspot = "done"
+end     syspot = "end"
+)");
+    ctx.compile_program(source);
+
+    std::string base = "/tmp/snobol_translate_" + std::to_string(getpid());
+    {
+        std::ofstream code(base + ".cpp");
+        ctx.translate(code);
+    }
+    std::string build = std::string(CXX_COMPILER) + " -std=c++17 -I" TEST_DIR "/.. " + base +
+                        ".cpp " BUILD_DIR "/libsnobol.a -o " + base;
+    ASSERT_EQ(std::system(build.c_str()), 0);
+
+    std::string run = "printf '12\\n-3\\n' | " + base + " > " + base + ".out";
+    ASSERT_EQ(std::system(run.c_str()), 0);
+    std::ifstream out(base + ".out");
+    std::string text((std::istreambuf_iterator<char>(out)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(text, "+12\n--3\ndone\nend\n");
+
+    unlink((base + ".cpp").c_str());
+    unlink((base + ".out").c_str());
+    unlink(base.c_str());
+}
+
+TEST_F(SnobolTest, Translate_DeepRecursionExits)
+{
+    std::istringstream source(R"(define  f(n)
+        m = ":" n ":"
+        m ":0:"                 /s(return)
+        f = f(n - "1") "x"      /(return)
+start   syspot = f("1000000")
+end     syspot = "end"
+)");
+    ctx.compile_program(source);
+
+    std::string base = "/tmp/snobol_translate_deep_" + std::to_string(getpid());
+    {
+        std::ofstream code(base + ".cpp");
+        ctx.translate(code);
+    }
+    std::string build = std::string(CXX_COMPILER) + " -std=c++17 -I" TEST_DIR "/.. " + base +
+                        ".cpp " BUILD_DIR "/libsnobol.a -o " + base;
+    ASSERT_EQ(std::system(build.c_str()), 0);
+
+    // Every call of a translated program nests on the C++ stack
+    std::string run = base + " > " + base + ".out < /dev/null";
+    int status      = std::system(run.c_str());
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 1);
+    std::ifstream out(base + ".out");
+    std::string text((std::istreambuf_iterator<char>(out)), std::istreambuf_iterator<char>());
+    EXPECT_NE(text.find("call depth exceeded"), std::string::npos);
+
+    unlink((base + ".cpp").c_str());
+    unlink((base + ".out").c_str());
+    unlink(base.c_str());
+}
+
+TEST_F(SnobolTest, Translate_TailRecursionConstantSpace)
+{
+    std::istringstream source(R"(define  f(n,a)
+        m = ":" n ":"
+        m ":0:"                 /s(done)
+        f = f(n - "1", a + "1") /(return)
+done    f = a                   /(return)
+start   syspot = f("1000000", "0")
+end     syspot = "end"
+)");
+    ctx.compile_program(source);
+
+    std::string base = "/tmp/snobol_translate_tail_" + std::to_string(getpid());
+    {
+        std::ofstream code(base + ".cpp");
+        ctx.translate(code);
+    }
+    std::string build = std::string(CXX_COMPILER) + " -std=c++17 -I" TEST_DIR "/.. " + base +
+                        ".cpp " BUILD_DIR "/libsnobol.a -o " + base;
+    ASSERT_EQ(std::system(build.c_str()), 0);
+
+    // The tail call reuses the frame of f, see reuse()
+    std::string run = base + " > " + base + ".out < /dev/null";
+    ASSERT_EQ(std::system(run.c_str()), 0);
+    std::ifstream out(base + ".out");
+    std::string text((std::istreambuf_iterator<char>(out)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(text, "1000000\nend\n");
+
+    unlink((base + ".cpp").c_str());
+    unlink((base + ".out").c_str());
+    unlink(base.c_str());
+}
+
+// ============================================================================
+// Operand Stack Tests
+// ============================================================================
+
+TEST_F(SnobolTest, OperandStack_EmptyAfterExecution)
+{
+    std::istringstream source(R"(define  twice(x)
+        twice = x x             /(return)
+start   line = syspit           /f(done)
+        syspot = "<" twice(line) ">" twice(twice(line))  /(start)
+done    syspot = "done"
+end     return
+)");
+    std::istringstream input("ab\n");
+    ctx.compile_program(source);
+    ctx.execute_program(input);
+
+    EXPECT_EQ(output_stream.str(), "<abab>abababab\ndone\n");
+    EXPECT_TRUE(ctx.operands.empty());
+}
+
+// ============================================================================
+// Integer Value Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Integer_ConvertedOnDemand)
+{
+    std::istringstream source(R"(start   n = "0"
+loop    n = n + "1"
+        n = n * "2"
+        n = n - "1"
+        i = i + "1"
+        i "4"                   /f(loop)
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    Node &name = ctx.cstr_to_node("n");
+    Node &n    = ctx.look(name);
+    ASSERT_EQ(n.tail->typ, Token::EXPR_INTEGER);
+    EXPECT_EQ(ctx.strbin(n.tail), 15);
+
+    ctx.text(n.tail);
+    EXPECT_NE(n.tail->typ, Token::EXPR_INTEGER);
+    EXPECT_TRUE(node_equals_cstr(n.tail, "15"));
+    ctx.delete_string(&name);
+}
+
+// ============================================================================
+// 64-bit Arithmetic Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Binstr_Int64Extremes)
+{
+    Node &min = ctx.binstr(INT64_MIN);
+    Node &max = ctx.binstr(INT64_MAX);
+
+    EXPECT_TRUE(node_equals_cstr(&min, "-9223372036854775808"));
+    EXPECT_TRUE(node_equals_cstr(&max, "9223372036854775807"));
+    EXPECT_EQ(ctx.strbin(&min), INT64_MIN);
+    EXPECT_EQ(ctx.strbin(&max), INT64_MAX);
+    EXPECT_EQ(ctx.rfail, 0);
+
+    ctx.delete_string(&min);
+    ctx.delete_string(&max);
+}
+
+TEST_F(SnobolTest, Strbin_OverflowFails)
+{
+    Node &str = ctx.cstr_to_node("9223372036854775808");
+
+    EXPECT_EQ(ctx.strbin(&str), 0);
+    EXPECT_EQ(ctx.rfail, 1);
+    ctx.delete_string(&str);
+}
+
+TEST(ArithmeticTest, CheckedOperations)
+{
+    int64_t result;
+
+    EXPECT_TRUE(SnobolContext::arith(Token::TOKEN_PLUS, 3000000000, 3000000000, result));
+    EXPECT_EQ(result, 6000000000);
+    EXPECT_FALSE(SnobolContext::arith(Token::TOKEN_PLUS, INT64_MAX, 1, result));
+    EXPECT_FALSE(SnobolContext::arith(Token::TOKEN_MINUS, INT64_MIN, 1, result));
+    EXPECT_FALSE(SnobolContext::arith(Token::TOKEN_MULT, INT64_MAX, 2, result));
+    EXPECT_FALSE(SnobolContext::arith(Token::TOKEN_DIV, 5, 0, result));
+    EXPECT_FALSE(SnobolContext::arith(Token::TOKEN_DIV, INT64_MIN, -1, result));
+    EXPECT_TRUE(SnobolContext::arith(Token::TOKEN_DIV, -7, 2, result));
+    EXPECT_EQ(result, -3);
+}
+
+// ============================================================================
+// Type Inference Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Infer_IntegerOnlyVariables)
+{
+    std::istringstream source(R"(define  sq(x)
+        sq = x * x              /(return)
+start   n = "0"
+        s = "0"
+loop    n = n + "1"
+        k = sq(n) + k
+        syspot = "n=" n
+        s = s "."
+        n "3"                   /f(loop)
+        syspot = k
+end     return
+)");
+    ctx.compile_program(source);
+
+    auto symbol = [this](const char *name) -> Node & {
+        Node &str = ctx.cstr_to_node(name);
+        Node &sym = ctx.look(str);
+        ctx.delete_string(&str);
+        return sym;
+    };
+    EXPECT_EQ(symbol("n").ch, SnobolContext::INTEGER_VARIABLE);
+    EXPECT_EQ(symbol("k").ch, SnobolContext::INTEGER_VARIABLE);
+    EXPECT_EQ(symbol("x").ch, SnobolContext::INTEGER_VARIABLE);
+    EXPECT_NE(symbol("s").ch, SnobolContext::INTEGER_VARIABLE);
+
+    // sq = x * x
+    Node *body = symbol("sq").tail->head->head;
+    EXPECT_EQ(body->tail->head->tail->head->head->typ, Token::TOKEN_INT_MULT);
+
+    ctx.execute_program(input_stream);
+    EXPECT_EQ(output_stream.str(), "n=1\nn=2\nn=3\n14\n");
+    EXPECT_EQ(symbol("n").tail->typ, Token::EXPR_INTEGER); // Not formatted in place
+}
+
+TEST_F(SnobolTest, Infer_DynamicStoreDisables)
+{
+    std::istringstream source(R"(start   n = "1"
+        n = n + "1"
+        $"n" = "x"
+end     syspot = n
+)");
+    ctx.compile_program(source);
+
+    Node &name = ctx.cstr_to_node("n");
+    EXPECT_NE(ctx.look(name).ch, SnobolContext::INTEGER_VARIABLE);
+    EXPECT_EQ(ctx.program->head->tail->head->tail->head->head->typ, Token::TOKEN_PLUS);
+    ctx.delete_string(&name);
+}
+
+// ============================================================================
+// Arbitrary-Precision Arithmetic Tests
+// ============================================================================
+
+TEST_F(SnobolTest, Bigop_KaratsubaSquareAndDivision)
+{
+    // (10^400 - 1)^2 = 10^800 - 2 10^400 + 1, long enough for Karatsuba
+    std::string nines(400, '9');
+    std::string square = std::string(399, '9') + "8" + std::string(399, '0') + "1";
+    Node &a            = ctx.cstr_to_node(nines.c_str());
+    Node &b            = ctx.cstr_to_node(nines.c_str());
+
+    Node *product = ctx.bigop(Token::TOKEN_MULT, a, b);
+    EXPECT_EQ(node_to_string(product), square);
+
+    Node *back = ctx.bigop(Token::TOKEN_DIV, *product, a);
+    EXPECT_EQ(node_to_string(back), nines);
+
+    Node &neg   = ctx.cstr_to_node("-1");
+    Node *lower = ctx.bigop(Token::TOKEN_PLUS, *product, neg);
+    EXPECT_EQ(node_to_string(ctx.bigop(Token::TOKEN_DIV, *lower, a)),
+              std::string(399, '9') + "8");
+
+    Node &zero = ctx.cstr_to_node("0");
+    EXPECT_EQ(ctx.rfail, 0);
+    ctx.bigop(Token::TOKEN_DIV, a, zero);
+    EXPECT_EQ(ctx.rfail, 1);
+}
+
+TEST_F(SnobolTest, Bigop_SignsAndCarries)
+{
+    Node &a = ctx.cstr_to_node("-1000000000000000000000");
+    Node &b = ctx.cstr_to_node("1");
+
+    EXPECT_EQ(node_to_string(ctx.bigop(Token::TOKEN_PLUS, a, b)), "-999999999999999999999");
+    EXPECT_EQ(node_to_string(ctx.bigop(Token::TOKEN_MINUS, b, a)), "1000000000000000000001");
+    EXPECT_EQ(node_to_string(ctx.bigop(Token::TOKEN_MULT, a, a)),
+              "1000000000000000000000000000000000000000000");
+    EXPECT_EQ(node_to_string(ctx.bigop(Token::TOKEN_DIV, a, b)), "-1000000000000000000000");
+    EXPECT_EQ(node_to_string(ctx.text(ctx.bigop(Token::TOKEN_MINUS, a, a))), "0");
+}
+
+TEST_F(SnobolTest, Bignums_OverflowContinuesExactly)
+{
+    std::istringstream source(R"(start   n = "1"
+loop    n = n * "1000"
+        i = i + "1"
+        i "8"                   /f(loop)
+        syspot = n
+        n = n + "9223372036854775807"
+        syspot = n - "9223372036854775807" - "1"
+end     return
+)");
+    ctx.bignums = true;
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "1" + std::string(24, '0') + "\n" + std::string(24, '9') + "\n");
+}
+
+TEST_F(SnobolTest, Bignums_KeepOperandFailure)
+{
+    std::istringstream source(R"(start   x = syspit + "1"      /f(eof)
+        syspot = x              /(start)
+eof     syspot = "eof"
+end     return
+)");
+    std::istringstream input("5\n99999999999999999999\n");
+    ctx.bignums = true;
+    ctx.compile_program(source);
+    ctx.execute_program(input);
+
+    EXPECT_EQ(output_stream.str(), "6\n100000000000000000000\neof\n");
+}
+
+TEST_F(SnobolTest, Frames_EmptyAfterExecution)
+{
+    std::istringstream source(R"(define  g(x)
+        g = x                   /(return)
+start   syspot = g(g("a") "b")  /($g("next"))
+next    x = g("9223372036854775807" + "1")
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "ab\n");
+    EXPECT_TRUE(ctx.frames.empty());
+    EXPECT_TRUE(ctx.calls.empty());
+}
+
+TEST_F(SnobolTest, Frames_DepthLimitExits)
+{
+    std::istringstream source(R"(define  f(x)
+        f = f(x) x              /(return)
+start   syspot = f("c")
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.max_depth = 10;
+    EXPECT_EXIT(ctx.execute_program(input_stream), ::testing::ExitedWithCode(1), "");
+}
+
+TEST_F(SnobolTest, Steps_LimitFailsTheMatch)
+{
+    std::istringstream source(R"(start   str = syspit
+        str *(a)* "y"           /s(end)
+        syspot = "stopped"
+        "abc" "c"               /f(end)
+        syspot = "small"
+end     return
+)");
+    std::istringstream input(std::string(100, 'x') + "y\n");
+    ctx.compile_program(source);
+    ctx.max_steps = 20;
+    ctx.execute_program(input);
+
+    EXPECT_EQ(output_stream.str(), "stopped\nsmall\n");
+    EXPECT_EQ(ctx.match_aborts, 1u);
+}
+
+TEST_F(SnobolTest, Steps_LimitPerStatement)
+{
+    std::istringstream source(R"(start   str = syspit
+        str "," == ";"          /f(over)
+        syspot = str            /(end)
+over    syspot = str
+        str = "a,b,c"
+        str "," == ";"          /f(end)
+        syspot = str
+end     return
+)");
+    std::string line;
+    for (int i = 0; i < 30; i++)
+        line += "x,";
+    std::istringstream input(line + "\n");
+    ctx.compile_program(source);
+    ctx.max_steps = 20;
+    ctx.execute_program(input);
+
+    // Each search of the first == takes a step, 31 in all
+    EXPECT_EQ(output_stream.str(), line + "\na;b;c\n");
+    EXPECT_EQ(ctx.match_aborts, 1u);
+}
+
+TEST_F(SnobolTest, TimeLimit_Exits)
+{
+    std::istringstream source(R"(start   n = "0"
+loop    n = n + "1"             /(loop)
+end     return
+)");
+    ctx.compile_program(source);
+    ctx.time_limit = 1;
+    EXPECT_EXIT(ctx.execute_program(input_stream), ::testing::ExitedWithCode(1), "");
+}
+
+TEST_F(SnobolTest, Bind_MovesValuesWithoutCopying)
+{
+    std::istringstream source(R"(define  f(x)
+        x = "body"
+        f = x                   /(return)
+start   syspot = f("arg")
+        syspot = x
+end     return
+)");
+    ctx.compile_program(source);
+    Node &x     = ctx.look(ctx.cstr_to_node("x"));
+    x.typ       = Token::EXPR_VALUE;
+    x.tail      = &ctx.cstr_to_node("outer");
+    Node *value = x.tail;
+    ctx.execute_program(input_stream);
+
+    EXPECT_EQ(output_stream.str(), "body\nouter\n");
+    EXPECT_EQ(x.tail, value); // The caller's string itself is put back
+}
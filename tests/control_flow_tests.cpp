@@ -216,6 +216,21 @@ end     syspot = "end"
     EXPECT_EQ(result.stdout_output, "5\nend\n");
 }
 
+TEST_F(ControlFlowTest, TightCounterLoop)
+{
+    std::string program = R"(
+start   n = "0"
+loop    n = n + "1"
+        n "200"                 /s(done)f(loop)
+done    syspot = n
+end     syspot = "end"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "200\nend\n");
+}
+
 TEST_F(ControlFlowTest, DISABLED_ConditionalExecution)
 {
     std::string program = R"(
@@ -328,3 +328,128 @@ end     return
     EXPECT_TRUE(result.success) << result.stderr_output;
     EXPECT_EQ(result.stdout_output, "10\n0\n");
 }
+
+// ============================================================================
+// Constant Folding Tests
+// ============================================================================
+
+TEST_F(ExpressionTest, FoldedConstantsInLoop)
+{
+    std::string program = R"(
+start   n = "0"
+loop    x = "10" * "60" "-" "prefix" "suffix"
+        n = n + "1"
+        n "3"                   /f(loop)
+        syspot = x
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "600-prefixsuffix\n");
+}
+
+TEST_F(ExpressionTest, UnfoldableLiteralOnlyFailsWhenExecuted)
+{
+    std::string program = R"(
+start   x = "1"                 /(skip)
+        x = "a" + "1"
+skip    syspot = "skipped"
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "skipped\n");
+}
+
+// ============================================================================
+// Operand Stack Tests
+// ============================================================================
+
+TEST_F(ExpressionTest, NestedCallsInsideOperands)
+{
+    std::string program = R"(
+define  add(a,b)
+        add = a + b             /(return)
+start   x = "1" add(add("2", "3") * "2", add("4", add("5", "6"))) "!"
+        syspot = x
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "125!\n");
+}
+
+// ============================================================================
+// Integer Value Tests
+// ============================================================================
+
+TEST_F(ExpressionTest, IntegerResultsInStringContexts)
+{
+    std::string program = R"(
+start   n = "12" * "10"
+        m = n + "3"
+        syspot = m
+        syspot = "<" m ">"
+        m "23"                  /f(end)
+        m "1" = "x"
+        syspot = m
+        v123 = "indirect"
+        syspot = $("v" n + "3")
+        k = n - n
+        syspot = k
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "123\n<123>\nx23\nindirect\n0\n");
+}
+
+TEST_F(ExpressionTest, OverflowFailsStatement)
+{
+    std::string program = R"(
+define  g(x)
+        syspot = "called"
+        g = x                   /(return)
+start   big = "9223372036854775807"
+        x = big + "1"           /s(bad)
+        x = big * "2" g("a")    /s(bad)
+        x = "5" / "0"           /s(bad)
+        n = big
+        n = n + "1"             /s(bad)
+        syspot = "failed " n
+        syspot = "3000000000" + "3000000000"  /(end)
+bad     syspot = "bad"
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "failed 9223372036854775807\n6000000000\n");
+}
+
+TEST_F(ExpressionTest, InferredIntegersBehaveLikeStrings)
+{
+    std::string program = R"(define  f(a,b)
+        f = a * "10" + b        /(return)
+start   n = "007"
+        m = "5"
+        t = m
+loop    t = f(t, m) - "1"
+        r = m "-" t "-" n
+        m = m + "1"
+        i = i + "1"
+        i "3"                   /f(loop)
+        syspot = r
+        syspot = t / "0"        /s(end)
+        syspot = "failed"
+end     syspot = n + t
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "7-5456-007\nfailed\n5463\n");
+}
@@ -285,8 +285,25 @@ end         syspot = "done"
 )";
 
     SnobolTestResult result = run_snobol_program(program);
-    // This tests freturn behavior
-    EXPECT_TRUE(result.success || !result.stderr_output.empty());
+    // The body falls through into start and recurses without end,
+    // which stops at the call depth limit instead of crashing
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.stdout_output.find("call depth exceeded"), std::string::npos);
+}
+
+TEST_F(FunctionTest, RecursionInPattern_StopsAtStackLimit)
+{
+    std::string program = R"(
+define      f(n)
+            "ab" *"z"/f(n)*             /(return)
+start       f("1")
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    // Calls made while matching nest on the C++ stack, see nest()
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.stdout_output.find("call depth exceeded"), std::string::npos);
 }
 
 TEST_F(FunctionTest, DISABLED_MultipleFunctions)
@@ -341,3 +358,223 @@ end     return
     EXPECT_TRUE(result.success) << result.stderr_output;
     EXPECT_EQ(result.stdout_output, "7\n");
 }
+
+// ============================================================================
+// Function Call Tests
+// ============================================================================
+
+TEST_F(FunctionTest, ReturnValueThroughFunctionName)
+{
+    std::string program = R"(
+define  double(x)
+        double = x + x              /(return)
+start   syspot = double("21")
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "42\ndone\n");
+}
+
+TEST_F(FunctionTest, RecursiveCall)
+{
+    std::string program = R"(
+define  fact(n)
+        n "0"                       /s(base)
+        fact = n * fact(n - "1")    /(return)
+base    fact = "1"                  /(return)
+start   syspot = fact("6")
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "720\ndone\n");
+}
+
+TEST_F(FunctionTest, ParameterRestoredAfterCall)
+{
+    std::string program = R"(
+define  inner(x)
+        inner = x "!"               /(return)
+start   x = "outer"
+        syspot = inner("inner")
+        syspot = x
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "inner!\nouter\ndone\n");
+}
+
+TEST_F(FunctionTest, DeepRecursion)
+{
+    std::string program = R"(
+define  d(n)
+        n "-"                       /s(base)
+        d = d(n - "1") + "1"        /(return)
+base    d = "0"                     /(return)
+start   syspot = d("50000")
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "50001\ndone\n");
+}
+
+TEST_F(FunctionTest, CallsInGotosAndArguments)
+{
+    std::string program = R"(
+define  f(x)
+        f = x x                     /(return)
+define  g(x)
+        g = "one"                   /(return)
+start   syspot = f(f("1"))          /($g("1"))
+one     syspot = "one"
+        y = f("9223372036854775807" + "1")      /s(end)
+        syspot = x
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "1111\none\n\ndone\n");
+}
+
+TEST_F(FunctionTest, ParameterRestoredAfterFreturn)
+{
+    std::string program = R"(
+define  g(x)
+        x = "changed"               /(freturn)
+start   x = "keep"
+        y = g("a")                  /s(end)
+        syspot = x
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "keep\ndone\n");
+}
+
+TEST_F(FunctionTest, ParametersRebindInRecursion)
+{
+    std::string program = R"(
+define  rev(s,n)
+        n "0"                       /s(base)
+        s = s "."
+        rev = n rev(s, n - "1") s   /(return)
+base    rev = "|"                   /(return)
+start   s = "s"
+        syspot = rev("x", "3")
+        syspot = s n "end"
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "321|x...x..x.\nsend\ndone\n");
+}
+
+TEST_F(FunctionTest, TailCallsRunInConstantSpace)
+{
+    std::string program = R"(
+define  even(n)
+        n "-"                       /s(yes)
+        even = odd(n - "1")         /(return)
+yes     even = "even"               /(return)
+define  odd(n)
+        n "-"                       /s(no)
+        odd = even(n - "1")         /(return)
+no      odd = "odd"                 /(return)
+start   n = "n"
+        syspot = even("200001") odd("200001") n
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "evenoddn\ndone\n");
+}
+
+TEST_F(FunctionTest, FailedTailCall)
+{
+    std::string program = R"(
+define  g(x)
+        x "a"                       /s(freturn)
+        g = "g" x                   /(return)
+define  f(x)
+        f = "f"
+        f = g(x)                    /(return)
+define  h(x)
+        h = "h"
+        h = g(x)                    /s(return)f(freturn)
+start   x = "x"
+        syspot = f("b")
+        syspot = f("a")
+        syspot = h("a")             /f(failed)
+failed  syspot = x
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "gb\nf\nx\ndone\n");
+}
+
+TEST_F(FunctionTest, MemoizedFunction)
+{
+    std::string program = R"(
+define  fib(n) memo
+        n "-"                       /s(small)
+        fib = fib(n - "1") + fib(n - "2")   /(return)
+small   fib = "1"                   /(return)
+define  noisy(x) memo
+        syspot = "called " x
+        noisy = x x                 /(return)
+start   syspot = fib("80")
+        syspot = noisy("a") noisy("a")
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "99194853094755497\ncalled a\ncalled a\naaaa\ndone\n");
+}
+
+TEST_F(FunctionTest, LocalVariables)
+{
+    std::string program = R"(
+define  join(s,n)t,k
+l       t = t s
+        k = k + "1"
+        k n                         /f(l)
+        join = t                    /(return)
+start   t = "T"
+        k = "K"
+        syspot = join("ab", "3") join("c", "2")
+        syspot = t k
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "abababcc\nTK\ndone\n");
+}
+
+TEST_F(FunctionTest, LocalsAreNotArguments)
+{
+    std::string program = R"(
+define  f(x)y
+        f = x y                     /(return)
+start   syspot = f("1", "2")
+end     syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_FALSE(result.success);
+    EXPECT_NE(result.stdout_output.find("parameters do not match"), std::string::npos);
+}
@@ -127,6 +127,69 @@ end         syspot = "done"
     EXPECT_EQ(result.stdout_output, "pattern not found\ndone\n");
 }
 
+TEST_F(PatternTest, UnanchoredSearch_SkipsToFirstCharacter)
+{
+    std::string program = R"(
+start       str = "abcabd"
+            str "ab" "d" = "X"          /f(end)
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "abcX\ndone\n");
+}
+
+TEST_F(PatternTest, UnanchoredSearch_LeadingStringVariable)
+{
+    std::string program = R"(
+start       str = "xxyzyz"
+            str *p* "yz" = "-"          /f(end)
+            syspot = p
+            syspot = str
+            str ** "q"                  /s(end)
+            syspot = "no q"
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "xx\n-yz\nno q\ndone\n");
+}
+
+TEST_F(PatternTest, StringVariable_SkipsToNextString)
+{
+    std::string program = R"(
+start       str = "xababcabcabcab"
+            str "x" *a* "abcabc" *b*
+            syspot = a
+            syspot = b
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "ab\nabcab\ndone\n");
+}
+
+TEST_F(PatternTest, StringVariable_SplitsLongLine)
+{
+    std::string program = R"(
+start       str = syspit
+loop        str *field* ";" = ""        /f(last)
+            syspot = field              /(loop)
+last        syspot = str
+end         syspot = "done"
+)";
+
+    std::string line = std::string(5000, 'a') + ";b;" + std::string(5000, 'c');
+    SnobolTestResult result = run_snobol_program(program, line + "\n");
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output,
+              std::string(5000, 'a') + "\nb\n" + std::string(5000, 'c') + "\ndone\n");
+}
+
 // ============================================================================
 // Pattern Alternation Tests
 // ============================================================================
@@ -143,10 +206,7 @@ end         syspot = "done"
 
     SnobolTestResult result = run_snobol_program(program);
     EXPECT_TRUE(result.success) << result.stderr_output;
-    EXPECT_EQ(result.stdout_output, "alternations are not supported yet\nnot found\ndone\n");
-
-    // TODO: enable when alterations are implemented
-    // TODO: EXPECT_EQ(result.stdout_output, "found\ndone\n");
+    EXPECT_EQ(result.stdout_output, "found\ndone\n");
 }
 
 TEST_F(PatternTest, SimpleAlternation_SecondMatch)
@@ -161,10 +221,7 @@ end         syspot = "done"
 
     SnobolTestResult result = run_snobol_program(program);
     EXPECT_TRUE(result.success) << result.stderr_output;
-    EXPECT_EQ(result.stdout_output, "alternations are not supported yet\nnot found\ndone\n");
-
-    // TODO: enable when alterations are implemented
-    // TODO: EXPECT_EQ(result.stdout_output, "found\ndone\n");
+    EXPECT_EQ(result.stdout_output, "found\ndone\n");
 }
 
 TEST_F(PatternTest, SimpleAlternation_NoMatch)
@@ -179,10 +236,7 @@ end         syspot = "done"
 
     SnobolTestResult result = run_snobol_program(program);
     EXPECT_TRUE(result.success) << result.stderr_output;
-    EXPECT_EQ(result.stdout_output, "alternations are not supported yet\nnot found\ndone\n");
-
-    // TODO: enable when alterations are implemented
-    // TODO: EXPECT_EQ(result.stdout_output, "not found\ndone\n");
+    EXPECT_EQ(result.stdout_output, "not found\ndone\n");
 }
 
 TEST_F(PatternTest, AlternationWithVariables)
@@ -199,10 +253,51 @@ end         syspot = "done"
 
     SnobolTestResult result = run_snobol_program(program);
     EXPECT_TRUE(result.success) << result.stderr_output;
-    EXPECT_EQ(result.stdout_output, "alternations are not supported yet\nnot found\ndone\n");
+    EXPECT_EQ(result.stdout_output, "found\ndone\n");
+}
 
-    // TODO: enable when alterations are implemented
-    // TODO: EXPECT_EQ(result.stdout_output, "found\ndone\n");
+TEST_F(PatternTest, AlternationBacktracks)
+{
+    std::string program = R"(
+start       str = "xabc"
+            str *"a"/"ab"* "c" = "-"    /f(end)
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "x-\ndone\n");
+}
+
+TEST_F(PatternTest, AdjacentStringVariables_FailQuickly)
+{
+    std::string program = R"(
+start       str = syspit
+            str *a* *b* *c* *d* *e* *f* "!"  /s(yes)
+            syspot = "no"               /(end)
+yes         syspot = "yes"
+end         syspot = "done"
+)";
+
+    // Without remembering failed states this takes about n^6 / 720 steps
+    SnobolTestResult result = run_snobol_program(program, std::string(400, 'x') + "\n");
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "no\ndone\n");
+}
+
+TEST_F(PatternTest, AdjacentStringVariables_Match)
+{
+    std::string program = R"(
+start       str = "abyzcxz!"
+            str *a* *"x"/"y"* *b* "z" "!"
+            syspot = a "|" b
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "ab|zcx\ndone\n");
 }
 
 // ============================================================================
@@ -221,10 +316,85 @@ end         syspot = "done"
 
     SnobolTestResult result = run_snobol_program(program);
     EXPECT_TRUE(result.success) << result.stderr_output;
-    EXPECT_EQ(result.stdout_output, "alternations are not supported yet\nnot found\ndone\n");
+    EXPECT_EQ(result.stdout_output, "found\ndone\n");
+}
+
+TEST_F(PatternTest, BalancedStringVariable)
+{
+    std::string program = R"(
+start       str = "f((a)b)c,d"
+            str "f" *(arg)* ","         /f(end)
+            syspot = arg
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "((a)b)c\ndone\n");
+}
+
+TEST_F(PatternTest, BalancedStringVariable_Unclosed)
+{
+    std::string program = R"(
+start       str = "(a,(b),c"
+            str *(x)* ","               /f(none)
+            syspot = x
+none        str "," *(y)* ","           /f(end)
+            syspot = y
+end         syspot = "done"
+)";
 
-    // TODO: enable when alterations are implemented
-    // TODO: EXPECT_EQ(result.stdout_output, "found\ndone\n");
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "a\n(b)\ndone\n");
+}
+
+TEST_F(PatternTest, BalancedStringVariable_NestedUnits)
+{
+    std::string program = R"(
+start       str = "((x)(y))((z)),w"
+            str *(a)* *(b)* ","         /f(end)
+            syspot = a
+            syspot = b
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "((x)(y))\n((z))\ndone\n");
+}
+
+TEST_F(PatternTest, ShortSubject_Fails)
+{
+    std::string program = R"(
+start       sep = ";"
+            str = "a;b"
+            str *x* sep *y* sep *z*     /s(long)
+            syspot = "short"
+            str = str ";c"
+            str *x* sep *y* sep *z*     /f(end)
+long        syspot = y
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "short\nb\ndone\n");
+}
+
+TEST_F(PatternTest, StringVariables)
+{
+    std::string program = R"(
+start       str = "key = value"
+            str *k* " = " *v*           /f(end)
+            syspot = k
+            syspot = v
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "key\nvalue\ndone\n");
 }
 
 // ============================================================================
@@ -304,6 +474,61 @@ end         return
     EXPECT_EQ(result.stdout_output, "hi hello\nhi hi\nhi hi\n");
 }
 
+TEST_F(PatternTest, GlobalReplacement)
+{
+    std::string program = R"(
+start       str = "hello hello, hello"
+            str "hello" == "hi"         /f(end)
+            syspot = str
+            str "bye" == "x"            /s(end)
+            syspot = "no match"
+            str "" == "."
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "hi hi, hi\nno match\n.h.i. .h.i.,. .h.i.\ndone\n");
+}
+
+TEST_F(PatternTest, GlobalReplacement_EmptyMatchAtEnd)
+{
+    std::string program = R"(
+start       str = "ab"
+            str "" == "-"
+            syspot = str
+            str = ""
+            str "" == "!"
+            syspot = str
+            str = "abc"
+            str *x* == "<" x ">"
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "-a-b-\n!\n<abc><>\ndone\n");
+}
+
+TEST_F(PatternTest, GlobalReplacement_StringVariables)
+{
+    std::string program = R"(
+start       str = "a=1;bb=22;c"
+            str *k* "=" *v* ";" == v ":" k ","
+            syspot = str
+            str = "f(x,(y)),g"
+            str *(e)* "," == "[" e "]"
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "1:a,22:bb,c\n[f(x,(y))]g\ndone\n");
+}
+
 TEST_F(PatternTest, EmptyPattern)
 {
     std::string program = R"(
@@ -318,3 +543,17 @@ end         syspot = "done"
     // Empty pattern should match (matches empty string)
     EXPECT_TRUE(result.success || !result.stderr_output.empty());
 }
+
+TEST_F(PatternTest, ReplacementInMiddle)
+{
+    std::string program = R"(
+start       str = "abcd"
+            str "bc" = "X"
+            syspot = str
+end         syspot = "done"
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "aXd\ndone\n");
+}
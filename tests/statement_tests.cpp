@@ -288,3 +288,52 @@ end     syspot = "end"
     EXPECT_TRUE(result.success) << result.stderr_output;
     EXPECT_EQ(result.stdout_output, "target reached\nend\n");
 }
+
+// ============================================================================
+// Fused Statement Tests
+// ============================================================================
+
+TEST_F(StatementTest, FusedReadWriteLoop)
+{
+    std::string program = R"(
+loop    x = syspit              /f(done)
+        syspot = x              /(loop)
+done    syspot = "done"
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program, "one\n\nthree\n");
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "one\n\nthree\ndone\n");
+}
+
+TEST_F(StatementTest, FusedIncrementAndFind)
+{
+    std::string program = R"(
+start   n = "10"
+loop    n = n - "3"
+        m = m + "1"
+        n "-"                   /f(loop)
+        syspot = n
+        syspot = m
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "-2\n4\n");
+}
+
+TEST_F(StatementTest, FusedIncrementOfFunctionFallsBack)
+{
+    std::string program = R"(
+define  count(x)
+        count = count + "1"     /(return)
+start   syspot = count("1")
+end     return
+)";
+
+    SnobolTestResult result = run_snobol_program(program);
+    EXPECT_TRUE(result.success) << result.stderr_output;
+    EXPECT_EQ(result.stdout_output, "1\n");
+}